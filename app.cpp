@@ -1,7 +1,11 @@
 #include <iostream>
 #include <fstream>
 #include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
 #include "pgm.h"
+#include "gradient.h"
 
 void generateGrayscaleImg(const char *filename = "test.pgm")
 {
@@ -76,18 +80,28 @@ void generateGrayscaleCircle(int width, int height, int radius, int stroke, bool
     file << img;
 }
 
+// Ramp value (i * 255) / (n - 1) for every i in [0, n), computed once instead of per pixel
+static std::vector<unsigned char> rampTable(int n)
+{
+    std::vector<unsigned char> ramp(n);
+    for (int i = 0; i < n; i++)
+    {
+        ramp[i] = static_cast<unsigned char>((i * 255) / std::max(1, n - 1));
+    }
+    return ramp;
+}
+
 void generateColorGradient(int width, int height, const char *filename = "gradient.ppm")
 {
     P6 img(width, height);
+    const std::vector<unsigned char> red = rampTable(img.width);    // Red gradient (per column)
+    const std::vector<unsigned char> green = rampTable(img.height); // Green gradient (per row)
     for (int y = 0; y < img.height; y++)
     {
-        for (int x = 0; x < img.width; x++)
-        {
-            img.r[y * img.width + x] = static_cast<unsigned char>((x * 255) / (img.width - 1));  // Red gradient
-            img.g[y * img.width + x] = static_cast<unsigned char>((y * 255) / (img.height - 1)); // Green gradient
-            img.b[y * img.width + x] = 128;                                                      // Constant blue value
-        }
+        std::copy(red.begin(), red.end(), img.r + y * img.width);
+        std::fill(img.g + y * img.width, img.g + (y + 1) * img.width, green[y]);
     }
+    std::fill(img.b, img.b + img.width * img.height, 128); // Constant blue value
 
     std::ofstream file(filename, std::ios::out | std::ios::binary);
     file << img;
@@ -161,25 +175,28 @@ void generateColorGradientCircle(int width, int height, int radius, const char *
     P6 img(width, height);
     const int centerX = width / 2;
     const int centerY = height / 2;
+    const std::vector<unsigned char> red = rampTable(img.width);
+    const std::vector<unsigned char> green = rampTable(img.height);
+    std::fill(img.r, img.r + img.width * img.height, 0);
+    std::fill(img.g, img.g + img.width * img.height, 0);
+    std::fill(img.b, img.b + img.width * img.height, 0);
 
     for (int y = 0; y < img.height; y++)
     {
-        for (int x = 0; x < img.width; x++)
+        // Only the circle's span on this row gets the gradient
+        const int dy = y - centerY;
+        const int rem = radius * radius - dy * dy;
+        if (rem < 0) continue;
+        int half = static_cast<int>(std::sqrt(static_cast<double>(rem)));
+        while (half * half > rem) half--;
+        while ((half + 1) * (half + 1) <= rem) half++;
+        const int x0 = std::max(0, centerX - half);
+        const int x1 = std::min(img.width - 1, centerX + half);
+        for (int x = x0; x <= x1; x++)
         {
-            const int dx = x - centerX;
-            const int dy = y - centerY;
-            if (dx * dx + dy * dy <= radius * radius)
-            {
-                img.r[y * img.width + x] = static_cast<unsigned char>((x * 255) / (img.width - 1));  // Red gradient
-                img.g[y * img.width + x] = static_cast<unsigned char>((y * 255) / (img.height - 1)); // Green gradient
-                img.b[y * img.width + x] = 128;                                                      // Constant blue value
-            }
-            else
-            {
-                img.r[y * img.width + x] = 0;
-                img.g[y * img.width + x] = 0;
-                img.b[y * img.width + x] = 0;
-            }
+            img.r[y * img.width + x] = red[x];      // Red gradient
+            img.g[y * img.width + x] = green[y];    // Green gradient
+            img.b[y * img.width + x] = 128;         // Constant blue value
         }
     }
 
@@ -187,6 +204,23 @@ void generateColorGradientCircle(int width, int height, int radius, const char *
     file << img;
 }
 
+// Multi-stop gradients from gradient.h: a conic rainbow disc on a dithered radial background
+void generateConicGradient(int width, int height, const char *filename = "conic_gradient.ppm")
+{
+    P6 img(width, height);
+    const std::vector<ColorStop> rainbow = {
+        {0.0, 255, 0, 0}, {1.0 / 3, 0, 255, 0}, {2.0 / 3, 0, 0, 255}, {1.0, 255, 0, 0}};
+    fillGradient(img, conicGradient(width / 2.0, height / 2.0, 0.0, rainbow));
+
+    Gradient vignette = radialGradient(width / 2.0, height / 2.0, std::min(width, height) / 2.0,
+                                       {{0.0, 255, 255, 255}, {1.0, 0, 0, 0}});
+    vignette.dither = true;
+    Pattern outside = !generateCirclePattern(width, height, std::min(width, height) / 3);
+    fillGradient(img, vignette, &outside);
+
+    std::ofstream file(filename, std::ios::out | std::ios::binary);
+    file << img;
+}
 
 int main(int argc, char **argv)
 {
@@ -195,6 +229,7 @@ int main(int argc, char **argv)
     // generateGrayscaleCircle(256, 256, 100, 5, false, "circle_2.pgm");
     // generateColorGradient(256, 256, (argc > 1) ? argv[1] : "gradient.ppm");
     // generatePointCloudImg(200, 256, 256);
+    // generateConicGradient(256, 256, (argc > 1) ? argv[1] : "conic_gradient.ppm");
     generateColorGradientCircle(256, 256, 100, (argc > 1) ? argv[1] : "gradient_circle.ppm");
     return 0;
 }
\ No newline at end of file
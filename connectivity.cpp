@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <cstdint>
+#include "connectivity.h"
+#include "parallel.h"
+
+namespace {
+
+int findRoot(std::vector<int> &parent, int x)
+{
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]]; // path halving
+        x = parent[x];
+    }
+    return x;
+}
+
+// Links the larger root under the smaller one, so a set's root is always its smallest label
+void unite(std::vector<int> &parent, int a, int b)
+{
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+// First pass over rows [y0, y1): provisional labels 1..n in raster order, equivalences in parent
+void labelBand(const Pattern &p, int y0, int y1, int *labels, std::vector<int> &parent)
+{
+    const int w = p.width;
+    parent.assign(1, 0);
+    for (int y = y0; y < y1; ++y) {
+        const bool *row = p.data + static_cast<size_t>(y) * w;
+        int *lab = labels + static_cast<size_t>(y) * w;
+        const int *up = (y > y0) ? lab - w : nullptr;
+        for (int x = 0; x < w; ++x) {
+            if (!row[x]) {
+                lab[x] = 0;
+                continue;
+            }
+            const int left = (x > 0) ? lab[x - 1] : 0;
+            const int above = up ? up[x] : 0;
+            if (left && above) {
+                lab[x] = std::min(left, above);
+                if (left != above) unite(parent, left, above);
+            } else if (left || above) {
+                lab[x] = left ? left : above;
+            } else {
+                lab[x] = static_cast<int>(parent.size());
+                parent.push_back(lab[x]);
+            }
+        }
+    }
+}
+
+} // namespace
+
+LabelMap labelComponentsParallel(const Pattern &p, int threads, int bandHeight)
+{
+    LabelMap map;
+    map.width = p.width;
+    map.height = p.height;
+    map.labels.assign(static_cast<size_t>(p.width) * p.height, 0);
+    if (p.width <= 0 || p.height <= 0) return map;
+
+    bandHeight = std::max(1, bandHeight);
+    const int bands = (p.height + bandHeight - 1) / bandHeight;
+    std::vector<std::vector<int>> bandParents(bands);
+    int *labels = map.labels.data();
+    parallelFor(bands, [&](int b) {
+        labelBand(p, b * bandHeight, std::min(p.height, (b + 1) * bandHeight), labels, bandParents[b]);
+    }, threads);
+
+    // Band-local labels become global by offsetting them past all earlier bands' labels
+    std::vector<int> offset(bands + 1, 0);
+    for (int b = 0; b < bands; ++b) offset[b + 1] = offset[b] + static_cast<int>(bandParents[b].size()) - 1;
+    std::vector<int> parent(offset[bands] + 1);
+    parent[0] = 0;
+    for (int b = 0; b < bands; ++b) {
+        for (size_t l = 1; l < bandParents[b].size(); ++l) parent[offset[b] + l] = offset[b] + bandParents[b][l];
+    }
+
+    // Merge components that touch across band borders
+    for (int b = 1; b < bands; ++b) {
+        const int *below = labels + static_cast<size_t>(b) * bandHeight * p.width;
+        const int *above = below - p.width;
+        for (int x = 0; x < p.width; ++x) {
+            if (below[x] && above[x]) unite(parent, below[x] + offset[b], above[x] + offset[b - 1]);
+        }
+    }
+
+    // Roots are the smallest label of their set, i.e. the component's first pixel in raster order,
+    // so numbering roots in label order gives the same result for any band height
+    std::vector<int> final(parent.size(), 0);
+    for (size_t l = 1; l < parent.size(); ++l) {
+        const int r = findRoot(parent, static_cast<int>(l));
+        final[l] = (r == static_cast<int>(l)) ? ++map.count : final[r];
+    }
+    parallelFor(bands, [&](int b) {
+        int *lab = labels + static_cast<size_t>(b) * bandHeight * p.width;
+        const size_t n = static_cast<size_t>(std::min(p.height, (b + 1) * bandHeight) - b * bandHeight) * p.width;
+        for (size_t i = 0; i < n; ++i) {
+            if (lab[i]) lab[i] = final[lab[i] + offset[b]];
+        }
+    }, threads);
+    return map;
+}
+
+LabelMap labelComponents(const Pattern &p)
+{
+    return labelComponentsParallel(p, 1, std::max(1, p.height));
+}
+
+std::vector<ComponentStats> componentStats(const LabelMap &map)
+{
+    std::vector<ComponentStats> stats(map.count);
+    std::vector<double> sumX(map.count, 0.0), sumY(map.count, 0.0);
+    for (int i = 0; i < map.count; ++i) {
+        stats[i].label = i + 1;
+        stats[i].bbox.x0 = map.width;
+        stats[i].bbox.y0 = map.height;
+    }
+    for (int y = 0; y < map.height; ++y) {
+        const int *row = map.labels.data() + static_cast<size_t>(y) * map.width;
+        for (int x = 0; x < map.width; ++x) {
+            if (!row[x]) continue;
+            ComponentStats &s = stats[row[x] - 1];
+            ++s.area;
+            s.bbox.x0 = std::min(s.bbox.x0, x);
+            s.bbox.y0 = std::min(s.bbox.y0, y);
+            s.bbox.x1 = std::max(s.bbox.x1, x + 1);
+            s.bbox.y1 = std::max(s.bbox.y1, y + 1);
+            sumX[row[x] - 1] += x;
+            sumY[row[x] - 1] += y;
+        }
+    }
+    for (int i = 0; i < map.count; ++i) {
+        stats[i].bbox.empty = false;
+        stats[i].centroidX = sumX[i] / static_cast<double>(stats[i].area);
+        stats[i].centroidY = sumY[i] / static_cast<double>(stats[i].area);
+    }
+    return stats;
+}
+
+Pattern componentMask(const LabelMap &map, int label)
+{
+    Pattern mask(map.width, map.height);
+    for (size_t i = 0; i < map.labels.size(); ++i) mask.data[i] = map.labels[i] == label;
+    return mask;
+}
+
+bool isFullyConnected(const Pattern &p)
+{
+    // Union-find over horizontal runs instead of pixels and no label map: components = runs - merges
+    std::vector<int> parent;
+    std::vector<int> prevStart, prevEnd, prevId, curStart, curEnd, curId;
+    long components = 0;
+    for (int y = 0; y < p.height; ++y) {
+        const bool *row = p.data + static_cast<size_t>(y) * p.width;
+        curStart.clear(); curEnd.clear(); curId.clear();
+        for (int x = 0; x < p.width; ) {
+            if (!row[x]) {
+                ++x;
+                continue;
+            }
+            const int x0 = x;
+            while (x < p.width && row[x]) ++x;
+            curStart.push_back(x0);
+            curEnd.push_back(x);
+            curId.push_back(static_cast<int>(parent.size()));
+            parent.push_back(static_cast<int>(parent.size()));
+            ++components;
+        }
+        // Runs in adjacent rows touch when their [start, end) intervals overlap
+        size_t j = 0;
+        for (size_t i = 0; i < curStart.size(); ++i) {
+            while (j < prevStart.size() && prevEnd[j] <= curStart[i]) ++j;
+            for (size_t k = j; k < prevStart.size() && prevStart[k] < curEnd[i]; ++k) {
+                const int a = findRoot(parent, curId[i]), b = findRoot(parent, prevId[k]);
+                if (a != b) {
+                    parent[std::max(a, b)] = std::min(a, b);
+                    --components;
+                }
+            }
+        }
+        prevStart.swap(curStart); prevEnd.swap(curEnd); prevId.swap(curId);
+    }
+    return components <= 1;
+}
+
+Pattern labyrinthPassages(const Pattern &carved)
+{
+    Pattern maze = carved;
+    for (int y = 0; y < maze.height; y += 2) {
+        for (int x = 0; x < maze.width; x += 2) maze.data[y * maze.width + x] = true;
+    }
+    return maze;
+}
+
+Pattern solveMaze(const Pattern &maze, int sx, int sy, int tx, int ty, int *length)
+{
+    const int w = maze.width, h = maze.height;
+    Pattern path(w, h);
+    if (length) *length = -1;
+    auto inside = [&](int x, int y) { return x >= 0 && x < w && y >= 0 && y < h && maze.data[y * w + x]; };
+    if (!inside(sx, sy) || !inside(tx, ty)) return path;
+
+    // from[i]: 0 = unvisited, 1..4 = reached by moving in direction from[i] - 1, 5 = start
+    const int dx[4] = {1, -1, 0, 0};
+    const int dy[4] = {0, 0, 1, -1};
+    std::vector<uint8_t> from(static_cast<size_t>(w) * h, 0);
+    std::vector<int> queue;
+    queue.reserve(1024);
+    const int start = sy * w + sx, target = ty * w + tx;
+    from[start] = 5;
+    queue.push_back(start);
+    for (size_t head = 0; head < queue.size() && !from[target]; ++head) {
+        const int cur = queue[head];
+        const int cx = cur % w, cy = cur / w;
+        for (int d = 0; d < 4; ++d) {
+            const int nx = cx + dx[d], ny = cy + dy[d];
+            if (!inside(nx, ny)) continue;
+            const int next = ny * w + nx;
+            if (from[next]) continue;
+            from[next] = static_cast<uint8_t>(d + 1);
+            queue.push_back(next);
+        }
+    }
+    if (!from[target]) return path;
+
+    int steps = 0;
+    for (int cur = target; ; ++steps) {
+        path.data[cur] = true;
+        if (from[cur] == 5) break;
+        const int d = from[cur] - 1;
+        cur -= dy[d] * w + dx[d];
+    }
+    if (length) *length = steps;
+    return path;
+}
@@ -0,0 +1,48 @@
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+#include <cstddef>
+#include <vector>
+#include "pattern.h"
+#include "pattern_stats.h"
+
+// Connectivity analysis on Patterns. Set (true) pixels are foreground; neighbours are 4-connected.
+
+// Per pixel component label: 0 = background, 1..count numbered in raster order of each component's first pixel
+struct LabelMap {
+    int width = 0;
+    int height = 0;
+    int count = 0;
+    std::vector<int> labels;
+};
+
+struct ComponentStats {
+    int label = 0;
+    size_t area = 0;
+    BoundingBox bbox;
+    double centroidX = 0;
+    double centroidY = 0;
+};
+
+// Two-pass union-find labeling
+LabelMap labelComponents(const Pattern &p);
+// Same labels as labelComponents; bands of rows are labeled in parallel and merged along their borders
+LabelMap labelComponentsParallel(const Pattern &p, int threads = 0, int bandHeight = 256);
+// Stats for labels 1..count (element i describes label i + 1)
+std::vector<ComponentStats> componentStats(const LabelMap &map);
+// Pixels carrying the given label
+Pattern componentMask(const LabelMap &map, int label);
+// True when all set pixels form a single component (also true for an empty Pattern). Unions horizontal
+// runs rather than pixels and builds no label map, so it is cheap enough to run on every generated maze.
+bool isFullyConnected(const Pattern &p);
+
+// labyrinthPatternGenerator only sets the carved walls between cells; the cells themselves (even x and y)
+// are passages too. Returns carved plus those cells, i.e. the maze as a walkable Pattern.
+Pattern labyrinthPassages(const Pattern &carved);
+
+// Shortest path between (sx, sy) and (tx, ty) over set pixels (breadth-first search).
+// Returns the path as an overlay Pattern of the same size; it is all false when either end is not a set
+// pixel or no path exists. length (optional) receives the number of steps, or -1 without a path.
+Pattern solveMaze(const Pattern &maze, int sx, int sy, int tx, int ty, int *length = nullptr);
+
+#endif // CONNECTIVITY_H
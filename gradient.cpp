@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "gradient.h"
+#include "parallel.h"
+
+namespace {
+
+const int lutSize = 1024;     // color entries along t in [0, 1]
+const int fracBits = 16;      // fixed point fraction of the stepped LUT position
+const int atanSize = 2048;    // entries of the conic angle table over tan in [0, 1]
+const int rowsPerTask = 16;
+const double twoPi = 6.283185307179586;
+
+// 4x4 Bayer matrix scaled to thresholds in [0, 256) for 8.8 fixed point colors
+const uint16_t bayer4[4][4] = {
+    {  8, 136,  40, 168},
+    {200,  72, 232, 104},
+    { 56, 184,  24, 152},
+    {248, 120, 216,  88},
+};
+
+// Gradient colors in 8.8 fixed point; gray LUTs only fill channel 0
+struct ColorLut {
+    uint16_t c[3][lutSize];
+};
+
+void buildLut(const std::vector<ColorStop> &stops, bool gray, ColorLut &lut)
+{
+    for (int i = 0; i < lutSize; ++i) {
+        const double t = static_cast<double>(i) / (lutSize - 1);
+        double rgb[3] = {0, 0, 0};
+        if (!stops.empty()) {
+            // Clamp to the end stops, otherwise interpolate within [stops[k].pos, stops[k + 1].pos)
+            size_t k = 0;
+            double f = 0.0;
+            if (t >= stops.back().pos) {
+                k = stops.size() - 1;
+            } else if (t > stops.front().pos) {
+                while (stops[k + 1].pos <= t) ++k;
+                f = (t - stops[k].pos) / (stops[k + 1].pos - stops[k].pos);
+            }
+            const ColorStop &a = stops[k];
+            const ColorStop &b = (f > 0.0) ? stops[k + 1] : a;
+            rgb[0] = a.r + f * (b.r - a.r);
+            rgb[1] = a.g + f * (b.g - a.g);
+            rgb[2] = a.b + f * (b.b - a.b);
+        }
+        if (gray) {
+            lut.c[0][i] = static_cast<uint16_t>(std::lround((0.299 * rgb[0] + 0.587 * rgb[1] + 0.114 * rgb[2]) * 256.0));
+        } else {
+            for (int ch = 0; ch < 3; ++ch) lut.c[ch][i] = static_cast<uint16_t>(std::lround(rgb[ch] * 256.0));
+        }
+    }
+}
+
+// atan(i / atanSize) in turns (0 .. 1/8) for i = 0 .. atanSize, plus one entry for interpolation;
+// replaces the per pixel atan2 of conic gradients
+std::vector<double> buildAtanTable()
+{
+    std::vector<double> turns(atanSize + 2);
+    for (int i = 0; i <= atanSize + 1; ++i) turns[i] = std::atan(static_cast<double>(i) / atanSize) / twoPi;
+    return turns;
+}
+
+// LUT index of every pixel in row y
+void rowIndices(const Gradient &g, const double *atanTurns, int y, int width, int *idx, double *scratch)
+{
+    const int last = lutSize - 1;
+    switch (g.kind) {
+        case GradientKind::Linear: {
+            const double dx = g.x1 - g.x0, dy = g.y1 - g.y0;
+            const double len2 = dx * dx + dy * dy;
+            if (len2 == 0.0) {
+                std::fill(idx, idx + width, 0);
+                break;
+            }
+            // t(x) = ((x - x0) dx + (y - y0) dy) / len2, stepped by dx / len2 per pixel in 16.16 fixed point
+            const double scale = static_cast<double>(last) * (1 << fracBits);
+            int64_t pos = std::llround(((0 - g.x0) * dx + (y - g.y0) * dy) / len2 * scale);
+            const int64_t step = std::llround(dx / len2 * scale);
+            const int64_t maxPos = static_cast<int64_t>(last) << fracBits;
+            pos += int64_t(1) << (fracBits - 1); // round to the nearest entry
+            for (int x = 0; x < width; ++x) {
+                idx[x] = static_cast<int>(std::min(std::max(pos, int64_t(0)), maxPos) >> fracBits);
+                pos += step;
+            }
+            break;
+        }
+        case GradientKind::Radial: {
+            // Squared distance advances by 2 dx + 1 per pixel; the square roots are taken in a separate
+            // pass so that loop vectorizes (measured faster than walking a squared-distance threshold table)
+            const double fy = y - g.y0;
+            double fx = 0 - g.x0;
+            double d2 = fx * fx + fy * fy;
+            for (int x = 0; x < width; ++x) {
+                scratch[x] = d2;
+                d2 += 2 * fx + 1;
+                fx += 1;
+            }
+            const double scale = (g.radius > 0) ? last / g.radius : 0.0;
+            for (int x = 0; x < width; ++x) {
+                const double v = std::sqrt(std::max(0.0, scratch[x])) * scale;
+                idx[x] = (v >= last) ? last : static_cast<int>(v + 0.5); // nearest entry, like linear and conic
+            }
+            break;
+        }
+        case GradientKind::Conic: {
+            // Angle from the octant of (fx, fy) and a table of atan over [0, 1]: one division per pixel, no atan2
+            const double start = g.angle / twoPi;
+            const double fy = y - g.y0;
+            const double ay = std::fabs(fy);
+            for (int x = 0; x < width; ++x) {
+                const double fx = x - g.x0;
+                const double ax = std::fabs(fx);
+                double a = 0.0;
+                if (ax > 0 || ay > 0) {
+                    // tan of the angle to the nearer axis, in [0, 1]; table entries are interpolated linearly
+                    const double pos = (ax >= ay ? ay / ax : ax / ay) * atanSize;
+                    const int i = static_cast<int>(pos);
+                    a = atanTurns[i] + (pos - i) * (atanTurns[i + 1] - atanTurns[i]);
+                    if (ay > ax) a = 0.25 - a;
+                }
+                if (fx < 0) a = 0.5 - a;
+                if (fy < 0) a = 1.0 - a;
+                double t = a - start;
+                t -= std::floor(t);
+                idx[x] = std::min(last, static_cast<int>(t * last + 0.5));
+            }
+            break;
+        }
+    }
+}
+
+inline unsigned char toByte(uint16_t v, bool dither, int x, int y)
+{
+    const int add = dither ? bayer4[y & 3][x & 3] : 128;
+    return static_cast<unsigned char>(std::min(255, (v + add) >> 8));
+}
+
+// Runs paintRow(y, idx, mrow, n) for every row; mrow is the mask row (nullptr = unmasked), n the pixels to paint
+template <typename PaintRow>
+void forEachRow(int width, int height, const Gradient &g, const Pattern *mask, PaintRow paintRow)
+{
+    const std::vector<double> atanTurns = (g.kind == GradientKind::Conic) ? buildAtanTable() : std::vector<double>();
+    const int tasks = (height + rowsPerTask - 1) / rowsPerTask;
+    parallelFor(tasks, [&](int t) {
+        std::vector<int> idx(width);
+        std::vector<double> scratch(width);
+        const int yEnd = std::min(height, (t + 1) * rowsPerTask);
+        for (int y = t * rowsPerTask; y < yEnd; ++y) {
+            const bool *mrow = nullptr;
+            int n = width;
+            if (mask) {
+                if (y >= mask->height) continue;
+                mrow = mask->data + static_cast<size_t>(y) * mask->width;
+                n = std::min(width, mask->width);
+            }
+            rowIndices(g, atanTurns.data(), y, n, idx.data(), scratch.data());
+            paintRow(y, idx.data(), mrow, n);
+        }
+    });
+}
+
+} // namespace
+
+Gradient linearGradient(double x0, double y0, double x1, double y1, const std::vector<ColorStop> &stops)
+{
+    Gradient g;
+    g.kind = GradientKind::Linear;
+    g.x0 = x0; g.y0 = y0;
+    g.x1 = x1; g.y1 = y1;
+    g.stops = stops;
+    return g;
+}
+
+Gradient radialGradient(double cx, double cy, double radius, const std::vector<ColorStop> &stops)
+{
+    Gradient g;
+    g.kind = GradientKind::Radial;
+    g.x0 = cx; g.y0 = cy;
+    g.radius = radius;
+    g.stops = stops;
+    return g;
+}
+
+Gradient conicGradient(double cx, double cy, double angle, const std::vector<ColorStop> &stops)
+{
+    Gradient g;
+    g.kind = GradientKind::Conic;
+    g.x0 = cx; g.y0 = cy;
+    g.angle = angle;
+    g.stops = stops;
+    return g;
+}
+
+void fillGradient(P6 &img, const Gradient &g, const Pattern *mask)
+{
+    ColorLut lut;
+    buildLut(g.stops, false, lut);
+    forEachRow(img.width, img.height, g, mask, [&](int y, const int *idx, const bool *mrow, int n) {
+        const size_t off = static_cast<size_t>(y) * img.width;
+        unsigned char *planes[3] = {img.r + off, img.g + off, img.b + off};
+        for (int ch = 0; ch < 3; ++ch) {
+            unsigned char *dst = planes[ch];
+            const uint16_t *c = lut.c[ch];
+            if (mrow) {
+                for (int x = 0; x < n; ++x) if (mrow[x]) dst[x] = toByte(c[idx[x]], g.dither, x, y);
+            } else {
+                for (int x = 0; x < n; ++x) dst[x] = toByte(c[idx[x]], g.dither, x, y);
+            }
+        }
+    });
+}
+
+void fillGradient(P5 &img, const Gradient &g, const Pattern *mask)
+{
+    ColorLut lut;
+    buildLut(g.stops, true, lut);
+    forEachRow(img.width, img.height, g, mask, [&](int y, const int *idx, const bool *mrow, int n) {
+        unsigned char *dst = img.img_data + static_cast<size_t>(y) * img.width;
+        const uint16_t *c = lut.c[0];
+        if (mrow) {
+            for (int x = 0; x < n; ++x) if (mrow[x]) dst[x] = toByte(c[idx[x]], g.dither, x, y);
+        } else {
+            for (int x = 0; x < n; ++x) dst[x] = toByte(c[idx[x]], g.dither, x, y);
+        }
+    });
+}
@@ -0,0 +1,38 @@
+#ifndef GRADIENT_H
+#define GRADIENT_H
+
+#include <vector>
+#include "pgm.h"
+#include "pattern.h"
+
+// A color at position pos in [0, 1] along the gradient
+struct ColorStop {
+    double pos;
+    unsigned char r, g, b;
+};
+
+enum class GradientKind { Linear, Radial, Conic };
+
+struct Gradient {
+    GradientKind kind = GradientKind::Linear;
+    double x0 = 0, y0 = 0;  // linear: start point (t = 0); radial/conic: center
+    double x1 = 1, y1 = 0;  // linear: end point (t = 1)
+    double radius = 1;      // radial: distance at which t = 1
+    double angle = 0;       // conic: angle (radians, clockwise from +x since y grows downwards) at which t = 0
+    bool dither = false;    // 4x4 ordered (Bayer) dithering to hide 8-bit banding
+    std::vector<ColorStop> stops; // sorted by pos; t outside the first/last stop clamps to them
+};
+
+Gradient linearGradient(double x0, double y0, double x1, double y1, const std::vector<ColorStop> &stops);
+Gradient radialGradient(double cx, double cy, double radius, const std::vector<ColorStop> &stops);
+Gradient conicGradient(double cx, double cy, double angle, const std::vector<ColorStop> &stops);
+
+// Paints the gradient into img; with a mask only pixels where the mask is true are written.
+// Colors come from a lookup table built from the stops. t is stepped incrementally in fixed point along
+// each row (linear), is the square root of an incrementally updated squared distance (radial, one sqrt
+// per pixel), or comes from an octant reduction and an atan table (conic, one division per pixel).
+void fillGradient(P6 &img, const Gradient &g, const Pattern *mask = nullptr);
+// Grayscale variant: stops are converted to luma (0.299 R + 0.587 G + 0.114 B)
+void fillGradient(P5 &img, const Gradient &g, const Pattern *mask = nullptr);
+
+#endif // GRADIENT_H
@@ -5,16 +5,12 @@
 #include <string>
 #include <iostream>
 #include <algorithm>
+#include <cstring>
+#include <cstdarg>
 #include "pgm.h"
 #include "pattern.h"
-
-struct Layer {
-    std::string name;
-    Pattern pattern;
-    bool negated = false;
-    char op = ' '; // ' ' for first, '&' = AND, '|' = OR, '^' = XOR
-    Layer(const std::string &n, const Pattern &p) : name(n), pattern(p) {}
-};
+#include "layer_cache.h"
+#include "layer_stack.h"
 
 void drawLayers(WINDOW *win, const std::vector<Layer> &layers, int highlight)
 {
@@ -35,22 +31,14 @@ void drawLayers(WINDOW *win, const std::vector<Layer> &layers, int highlight)
     wrefresh(win);
 }
 
-Pattern combineLayers(const std::vector<Layer> &layers, int width, int height)
+// LIMG output is not a PGM/PPM file, so give it a .limg extension instead of the one typed in
+std::string exportFilename(const char *name, ImageFormat fmt)
 {
-    if (layers.empty()) return Pattern(width, height);
-    Pattern acc = layers[0].pattern; // copy
-    if (layers[0].negated) acc = acc.operator!();
-    for (size_t i = 1; i < layers.size(); ++i) {
-        Pattern cur = layers[i].pattern;
-        if (layers[i].negated) cur = cur.operator!();
-        switch (layers[i].op) {
-            case '&': acc = acc && cur; break;
-            case '|': acc = acc || cur; break;
-            case '^': acc = acc ^ cur; break;
-            default: acc = cur; break;
-        }
-    }
-    return acc;
+    std::string fn(name);
+    if (fmt != ImageFormat::Limg) return fn;
+    size_t dot = fn.find_last_of('.');
+    if (dot != std::string::npos && fn.find('/', dot) == std::string::npos) fn.erase(dot);
+    return fn + ".limg";
 }
 
 void promptCentered(int y, const char *fmt, ...)
@@ -102,14 +90,14 @@ int main()
                 std::string name = namebuf;
                 if (type == 'c') {
                     echo(); promptCentered(LINES-7, "Radius: "); int r; mvscanw(LINES-6, (COLS-20)/2 + 8, "%d", &r); noecho();
-                    p = generateCirclePattern(width, height, r);
+                    p = cachedCirclePattern(defaultLayerCache(), width, height, r);
                     name += " (circle)";
                 } else if (type == 't') {
-                    p = generateTrianglePattern(width, height);
+                    p = cachedTrianglePattern(defaultLayerCache(), width, height);
                     name += " (triangle)";
                 } else if (type == 'b') {
                     echo(); promptCentered(LINES-7, "Square size: "); int s; mvscanw(LINES-6, (COLS-20)/2 + 14, "%d", &s); noecho();
-                    p = generateCheckerboardPattern(width, height, s);
+                    p = cachedCheckerboardPattern(defaultLayerCache(), width, height, s);
                     name += " (checker)";
                 } else if (type == 'l') {
                     echo(); promptCentered(LINES-7, "Filename in ./patterns/ (e.g. gui_generated.pgm): "); char fnb[128]; mvgetnstr(LINES-6, (COLS-60)/2 + 34, fnb, 120); noecho();
@@ -122,10 +110,9 @@ int main()
                         name += " (load:fail)";
                     } else name += std::string(" (loaded: ") + fnb + ")";
                 } else if (type == 'm') {
-                    // Maze: carve on empty base
-                    Pattern base(width, height);
-                    Pattern visited(width, height);
-                    p = labyrinthPatternGenerator(base, visited, 0, 0);
+                    // Maze: carve on empty base; same seed -> same maze (served from the layer cache)
+                    echo(); promptCentered(LINES-7, "Seed: "); unsigned seed = 0; mvscanw(LINES-6, (COLS-20)/2 + 6, "%u", &seed); noecho();
+                    p = cachedLabyrinthPattern(defaultLayerCache(), width, height, seed);
                     name += " (maze)";
                 } else {
                     promptCentered(LINES-7, "Unknown type (press any key)"); getch();
@@ -183,7 +170,7 @@ int main()
                 if (layers.empty()) {
                     promptCentered(LINES-7, "No layers to preview (press any key)"); getch(); break;
                 }
-                Pattern combined = combineLayers(layers, width, height);
+                Pattern combined = combineLayersTiled(layers, width, height);
                 savePatternAsPgm(combined, "gui_preview.pgm");
                 promptCentered(LINES-7, "Preview saved to ./patterns/gui_preview.pgm (press any key)"); getch();
                 break;
@@ -192,11 +179,14 @@ int main()
             case 'x': case 'X': {
                 // Export options
                 promptCentered(LINES-7, "Export as [5] P5 (PGM) or [6] P6 (PPM): "); int t = getch();
+                promptCentered(LINES-7, "Encoding: [r] raw Netpbm  [l] LIMG (compact, lossless)"); int enc = getch();
+                ImageFormat fmt = (enc == 'l' || enc == 'L') ? ImageFormat::Limg : ImageFormat::Netpbm;
                 if (t == '5') {
                     echo(); promptCentered(LINES-7, "Output filename (in ./patterns/): "); char ofn[128]; mvgetnstr(LINES-6, (COLS-40)/2 + 28, ofn, 120); noecho();
-                    Pattern combined = combineLayers(layers, width, height);
-                    savePatternAsPgm(combined, ofn);
-                    promptCentered(LINES-7, "Saved ./patterns/%s (press any key)", ofn); getch();
+                    Pattern combined = combineLayersTiled(layers, width, height);
+                    std::string out = exportFilename(ofn, fmt);
+                    savePatternAsPgm(combined, out.c_str(), fmt);
+                    promptCentered(LINES-7, "Saved ./patterns/%s (press any key)", out.c_str()); getch();
                 } else if (t == '6') {
                     promptCentered(LINES-7, "P6 mode: [1] 3-layer  [2] Single combined->channel");
                     int pmode = getch();
@@ -213,14 +203,15 @@ int main()
                         if (ri < 0 || gi < 0 || bi < 0 || ri >= (int)layers.size() || gi >= (int)layers.size() || bi >= (int)layers.size()) {
                             promptCentered(LINES-7, "Invalid indices (press any key)"); getch(); break;
                         }
-                        patternMixer(layers[ri].pattern, layers[gi].pattern, layers[bi].pattern, bv, ofn);
-                        promptCentered(LINES-7, "Saved ./patterns/%s (press any key)", ofn); getch();
+                        std::string out = exportFilename(ofn, fmt);
+                        patternMixer(layers[ri].pattern, layers[gi].pattern, layers[bi].pattern, bv, out.c_str(), fmt);
+                        promptCentered(LINES-7, "Saved ./patterns/%s (press any key)", out.c_str()); getch();
                     } else if (pmode == '2') {
                         // Single channel export: combined pattern goes into one channel
                         echo(); promptCentered(LINES-7, "Channel to fill: [r] [g] [b]: "); int chsel = getch();
                         promptCentered(LINES-7, "Base value (1-255): "); int bv; mvscanw(LINES-6, (COLS-40)/2 + 16, "%d", &bv);
                         promptCentered(LINES-7, "Output filename (in ./patterns/): "); char ofn[128]; mvgetnstr(LINES-6, (COLS-40)/2 + 28, ofn, 120); noecho();
-                        Pattern combined = combineLayers(layers, width, height);
+                        Pattern combined = combineLayersTiled(layers, width, height);
                         Pattern pr(width, height), pg(width, height), pb(width, height);
                         for (int i = 0; i < width*height; ++i) {
                             bool v = combined.data[i];
@@ -228,8 +219,9 @@ int main()
                             pg.data[i] = (chsel == 'g' || chsel == 'G') ? v : false;
                             pb.data[i] = (chsel == 'b' || chsel == 'B') ? v : false;
                         }
-                        patternMixer(pr, pg, pb, bv, ofn);
-                        promptCentered(LINES-7, "Saved ./patterns/%s (press any key)", ofn); getch();
+                        std::string out = exportFilename(ofn, fmt);
+                        patternMixer(pr, pg, pb, bv, out.c_str(), fmt);
+                        promptCentered(LINES-7, "Saved ./patterns/%s (press any key)", out.c_str()); getch();
                     }
                 }
                 break;
@@ -0,0 +1,255 @@
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <unistd.h>
+#include "layer_cache.h"
+
+std::string LayerKey::str() const
+{
+    std::string s = generator + "/" + std::to_string(width) + "x" + std::to_string(height) + "/s" + std::to_string(seed);
+    for (int p : params) s += "/" + std::to_string(p);
+    return s;
+}
+
+// 64-bit FNV-1a, used to derive the on-disk file name of a key
+static uint64_t hashKey(const std::string &key)
+{
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static size_t patternBytes(const Pattern &p)
+{
+    return static_cast<size_t>(p.width) * static_cast<size_t>(p.height) * sizeof(bool);
+}
+
+LayerCache::LayerCache(size_t budget, const char *diskDir) : byteBudget(budget)
+{
+    if (diskDir && *diskDir) dir = diskDir;
+}
+
+bool LayerCache::lookup(const LayerKey &key, Pattern &out)
+{
+    const std::string k = key.str();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = index.find(k);
+        if (it != index.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            out = it->second->pattern;
+            ++hitCount;
+            return true;
+        }
+        if (dir.empty()) {
+            ++missCount;
+            return false;
+        }
+    }
+    // File I/O runs unlocked so other threads (and stats getters) are not held up by it
+    const bool found = loadFromDisk(k, out);
+    std::lock_guard<std::mutex> lock(mtx);
+    if (found) {
+        insertLocked(k, out);
+        ++hitCount;
+    } else {
+        ++missCount;
+    }
+    return found;
+}
+
+void LayerCache::insert(const LayerKey &key, const Pattern &p)
+{
+    const std::string k = key.str();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        insertLocked(k, p);
+    }
+    if (!dir.empty()) saveToDisk(k, p);
+}
+
+void LayerCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    lru.clear();
+    index.clear();
+    used = 0;
+}
+
+size_t LayerCache::bytesUsed() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return used;
+}
+
+size_t LayerCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return hitCount;
+}
+
+size_t LayerCache::misses() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return missCount;
+}
+
+void LayerCache::insertLocked(const std::string &key, const Pattern &p)
+{
+    // Layers bigger than the whole budget are never kept in memory
+    if (patternBytes(p) > byteBudget) return;
+    auto it = index.find(key);
+    if (it != index.end()) {
+        used -= patternBytes(it->second->pattern);
+        lru.erase(it->second);
+        index.erase(it);
+    }
+    lru.emplace_front(key, p);
+    index[key] = lru.begin();
+    used += patternBytes(p);
+    evictLocked();
+}
+
+void LayerCache::evictLocked()
+{
+    while (used > byteBudget && !lru.empty()) {
+        Entry &victim = lru.back();
+        used -= patternBytes(victim.pattern);
+        index.erase(victim.key);
+        lru.pop_back();
+    }
+}
+
+std::string LayerCache::diskPath(const std::string &key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.lmk", static_cast<unsigned long long>(hashKey(key)));
+    return dir + "/" + name;
+}
+
+// On-disk mask layout: "LMSK\n<key>\n<width> <height>\n" followed by rows packed 8 pixels per byte (MSB first)
+bool LayerCache::loadFromDisk(const std::string &key, Pattern &out) const
+{
+    std::ifstream file(diskPath(key).c_str(), std::ios::in | std::ios::binary);
+    if (!file) return false;
+
+    std::string magic, storedKey;
+    std::getline(file, magic);
+    std::getline(file, storedKey);
+    if (magic != "LMSK" || storedKey != key) return false; // hash collision or foreign file
+
+    int width = 0, height = 0;
+    file >> width >> height;
+    file.get();
+    if (!file || width <= 0 || height <= 0) return false;
+
+    const int rowBytes = (width + 7) / 8;
+    std::vector<unsigned char> packed(static_cast<size_t>(rowBytes) * height);
+    file.read(reinterpret_cast<char*>(packed.data()), packed.size());
+    if (!file) {
+        std::cerr << "Truncated cache entry " << diskPath(key) << "\n";
+        return false;
+    }
+
+    Pattern p(width, height);
+    for (int y = 0; y < height; ++y) {
+        const unsigned char *row = &packed[static_cast<size_t>(y) * rowBytes];
+        for (int x = 0; x < width; ++x) p.data[y * width + x] = (row[x >> 3] >> (7 - (x & 7))) & 1;
+    }
+    out = p;
+    return true;
+}
+
+void LayerCache::saveToDisk(const std::string &key, const Pattern &p) const
+{
+    const int rowBytes = (p.width + 7) / 8;
+    std::vector<unsigned char> packed(static_cast<size_t>(rowBytes) * p.height, 0);
+    for (int y = 0; y < p.height; ++y) {
+        unsigned char *row = &packed[static_cast<size_t>(y) * rowBytes];
+        for (int x = 0; x < p.width; ++x) {
+            if (p.data[y * p.width + x]) row[x >> 3] |= static_cast<unsigned char>(0x80 >> (x & 7));
+        }
+    }
+
+    // Written to a temporary file first and renamed into place, so readers never see a partial entry
+    static std::atomic<unsigned long> tempCounter(0);
+    const std::string out_path = diskPath(key);
+    const std::string tmp_path = out_path + ".tmp." + std::to_string(static_cast<long>(getpid())) + "." + std::to_string(++tempCounter);
+    std::ofstream file(tmp_path.c_str(), std::ios::out | std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << tmp_path << " for writing\n";
+        return;
+    }
+    file << "LMSK\n" << key << "\n" << p.width << ' ' << p.height << "\n";
+    file.write(reinterpret_cast<const char*>(packed.data()), packed.size());
+    file.close();
+    if (!file) {
+        std::cerr << "Failed while writing " << tmp_path << "\n";
+        std::remove(tmp_path.c_str());
+        return;
+    }
+    if (std::rename(tmp_path.c_str(), out_path.c_str()) != 0) {
+        std::cerr << "Failed to rename " << tmp_path << " to " << out_path << "\n";
+        std::remove(tmp_path.c_str());
+    }
+}
+
+LayerCache &defaultLayerCache()
+{
+    static LayerCache cache(64u << 20, std::getenv("LEARNIMG_CACHE_DIR"));
+    return cache;
+}
+
+Pattern cachedCirclePattern(LayerCache &cache, int width, int height, int radius)
+{
+    LayerKey key("circle", {radius}, width, height);
+    Pattern p(0, 0);
+    if (cache.lookup(key, p)) return p;
+    p = generateCirclePattern(width, height, radius);
+    cache.insert(key, p);
+    return p;
+}
+
+Pattern cachedTrianglePattern(LayerCache &cache, int width, int height)
+{
+    LayerKey key("triangle", {}, width, height);
+    Pattern p(0, 0);
+    if (cache.lookup(key, p)) return p;
+    p = generateTrianglePattern(width, height);
+    cache.insert(key, p);
+    return p;
+}
+
+Pattern cachedCheckerboardPattern(LayerCache &cache, int width, int height, int squareSize)
+{
+    LayerKey key("checker", {squareSize}, width, height);
+    Pattern p(0, 0);
+    if (cache.lookup(key, p)) return p;
+    p = generateCheckerboardPattern(width, height, squareSize);
+    cache.insert(key, p);
+    return p;
+}
+
+Pattern cachedLabyrinthPattern(LayerCache &cache, int width, int height, unsigned seed)
+{
+    LayerKey key("maze", {}, width, height, seed);
+    Pattern p(0, 0);
+    if (cache.lookup(key, p)) return p;
+    {
+        // labyrinthPatternGenerator draws from the global rand() state; keep concurrent seeds apart
+        static std::mutex randMutex;
+        std::lock_guard<std::mutex> lock(randMutex);
+        srand(seed);
+        Pattern base(width, height);
+        Pattern visited(width, height);
+        p = labyrinthPatternGenerator(base, visited, 0, 0);
+    }
+    cache.insert(key, p);
+    return p;
+}
@@ -0,0 +1,76 @@
+#ifndef LAYER_CACHE_H
+#define LAYER_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "pattern.h"
+
+// Identifies a generated layer: generator name, its integer parameters, the canvas size and the RNG seed
+struct LayerKey {
+    std::string generator;
+    std::vector<int> params;
+    int width;
+    int height;
+    unsigned seed;
+    LayerKey(const std::string &gen, std::vector<int> p, int w, int h, unsigned s = 0)
+        : generator(gen), params(std::move(p)), width(w), height(h), seed(s) {}
+    // Canonical string form, e.g. "circle/256x256/s0/30"
+    std::string str() const;
+};
+
+// Memoizes generated Patterns in an LRU bounded by a byte budget.
+// When a directory is given, entries are also persisted there as bit-packed masks
+// and picked up again on a memory miss (survives process restarts). Disk reads and writes
+// happen outside the lock; entries are written to a temporary file and renamed into place.
+class LayerCache {
+public:
+    explicit LayerCache(size_t byteBudget = 64u << 20, const char *diskDir = nullptr);
+
+    // Copies the cached Pattern into out and returns true on a hit (memory first, then disk)
+    bool lookup(const LayerKey &key, Pattern &out);
+    void insert(const LayerKey &key, const Pattern &p);
+    void clear();
+
+    size_t bytesUsed() const;
+    size_t budget() const { return byteBudget; }
+    size_t hits() const;
+    size_t misses() const;
+
+private:
+    struct Entry {
+        std::string key;
+        Pattern pattern;
+        Entry(const std::string &k, const Pattern &p) : key(k), pattern(p) {}
+    };
+
+    void insertLocked(const std::string &key, const Pattern &p);
+    void evictLocked();
+    std::string diskPath(const std::string &key) const;
+    bool loadFromDisk(const std::string &key, Pattern &out) const;
+    void saveToDisk(const std::string &key, const Pattern &p) const;
+
+    size_t byteBudget;
+    size_t used = 0;
+    size_t hitCount = 0;
+    size_t missCount = 0;
+    std::string dir;
+    std::list<Entry> lru; // front = most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    mutable std::mutex mtx;
+};
+
+// Process-wide cache; persists to $LEARNIMG_CACHE_DIR when that variable is set
+LayerCache &defaultLayerCache();
+
+// Cached variants of the generators in pattern.h
+Pattern cachedCirclePattern(LayerCache &cache, int width, int height, int radius);
+Pattern cachedTrianglePattern(LayerCache &cache, int width, int height);
+Pattern cachedCheckerboardPattern(LayerCache &cache, int width, int height, int squareSize);
+// Seeds rand() with seed before carving, so the same seed always yields the same maze
+Pattern cachedLabyrinthPattern(LayerCache &cache, int width, int height, unsigned seed);
+
+#endif // LAYER_CACHE_H
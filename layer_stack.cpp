@@ -0,0 +1,83 @@
+#include <algorithm>
+#include "layer_stack.h"
+#include "parallel.h"
+
+Pattern combineLayers(const std::vector<Layer> &layers, int width, int height)
+{
+    if (layers.empty()) return Pattern(width, height);
+    Pattern acc = layers[0].pattern; // copy
+    if (layers[0].negated) acc = acc.operator!();
+    for (size_t i = 1; i < layers.size(); ++i) {
+        Pattern cur = layers[i].pattern;
+        if (layers[i].negated) cur = cur.operator!();
+        switch (layers[i].op) {
+            case '&': acc = acc && cur; break;
+            case '|': acc = acc || cur; break;
+            case '^': acc = acc ^ cur; break;
+            default: acc = cur; break;
+        }
+    }
+    return acc;
+}
+
+// Applies one layer to the span [x0, x1) of row y of the accumulator.
+// Bools are handled as 0/1 bytes so the inner loops vectorize.
+static void applyLayerSpan(unsigned char *acc, const Layer &layer, bool first, int y, int x0, int x1)
+{
+    const Pattern &p = layer.pattern;
+    const unsigned char neg = layer.negated ? 1 : 0;
+    const char op = first ? ' ' : layer.op;
+    const int n = x1 - x0;
+
+    // Part of the span that lies inside this layer; the rest reads as false (or true when negated)
+    const int inside = (y < p.height) ? std::max(0, std::min(x1, p.width) - x0) : 0;
+    const unsigned char *src = inside ? reinterpret_cast<const unsigned char*>(p.data) + static_cast<size_t>(y) * p.width + x0 : nullptr;
+
+    switch (op) {
+        case '&':
+            for (int i = 0; i < inside; ++i) acc[i] &= src[i] ^ neg;
+            for (int i = inside; i < n; ++i) acc[i] &= neg;
+            break;
+        case '|':
+            for (int i = 0; i < inside; ++i) acc[i] |= src[i] ^ neg;
+            for (int i = inside; i < n; ++i) acc[i] |= neg;
+            break;
+        case '^':
+            for (int i = 0; i < inside; ++i) acc[i] ^= src[i] ^ neg;
+            for (int i = inside; i < n; ++i) acc[i] ^= neg;
+            break;
+        default:
+            for (int i = 0; i < inside; ++i) acc[i] = src[i] ^ neg;
+            for (int i = inside; i < n; ++i) acc[i] = neg;
+            break;
+    }
+}
+
+Pattern combineLayersTiled(const std::vector<Layer> &layers, int width, int height,
+                           int threads, int tileWidth, int tileHeight)
+{
+    const int w = width;
+    const int h = height;
+    Pattern result(w, h);
+    if (layers.empty() || w <= 0 || h <= 0) return result;
+
+    tileWidth = std::max(1, std::min(tileWidth, w));
+    tileHeight = std::max(1, std::min(tileHeight, h));
+    const int tilesX = (w + tileWidth - 1) / tileWidth;
+    const int tilesY = (h + tileHeight - 1) / tileHeight;
+    unsigned char *out = reinterpret_cast<unsigned char*>(result.data);
+
+    parallelFor(tilesX * tilesY, [&](int t) {
+        const int x0 = (t % tilesX) * tileWidth;
+        const int y0 = (t / tilesX) * tileHeight;
+        const int x1 = std::min(x0 + tileWidth, w);
+        const int y1 = std::min(y0 + tileHeight, h);
+        // Layer-outer loop: the tile's accumulator rows stay hot while each layer streams past
+        for (size_t l = 0; l < layers.size(); ++l) {
+            for (int y = y0; y < y1; ++y) {
+                applyLayerSpan(out + static_cast<size_t>(y) * w + x0, layers[l], l == 0, y, x0, x1);
+            }
+        }
+    }, threads);
+    return result;
+}
@@ -0,0 +1,28 @@
+#ifndef LAYER_STACK_H
+#define LAYER_STACK_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "pattern.h"
+
+struct Layer {
+    std::string name;
+    Pattern pattern;
+    bool negated = false;
+    char op = ' '; // ' ' for first, '&' = AND, '|' = OR, '^' = XOR
+    Layer(const std::string &n, const Pattern &p) : name(n), pattern(p) {}
+    Layer(const std::string &n, Pattern &&p) : name(n), pattern(std::move(p)) {}
+};
+
+// Reference evaluator: applies each layer to the whole canvas in turn (one full pass per layer)
+Pattern combineLayers(const std::vector<Layer> &layers, int width, int height);
+
+// Same result as combineLayers, but the canvas is cut into tileWidth x tileHeight tiles and the whole
+// stack is applied to one tile while its accumulator is still in cache. Tiles are spread over `threads`
+// workers (<= 0: all cores). The output is always width x height; pixels outside a smaller layer read
+// as false and parts of a larger layer beyond the canvas are ignored.
+Pattern combineLayersTiled(const std::vector<Layer> &layers, int width, int height,
+                           int threads = 0, int tileWidth = 256, int tileHeight = 64);
+
+#endif // LAYER_STACK_H
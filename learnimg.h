@@ -0,0 +1,22 @@
+#ifndef LEARNIMG_H
+#define LEARNIMG_H
+
+// Single include for using LearnImg as a library (see "Using as a library" in readme.md).
+// Everything declared through this header is the public API; the version is bumped on breaking changes.
+
+#define LEARNIMG_VERSION_MAJOR 1
+#define LEARNIMG_VERSION_MINOR 0
+
+#include "pgm.h"
+#include "pattern.h"
+#include "limg.h"
+#include "memstream.h"
+#include "layer_cache.h"
+#include "layer_stack.h"
+#include "pattern_stats.h"
+#include "sweep.h"
+#include "gradient.h"
+#include "connectivity.h"
+#include "parallel.h"
+
+#endif // LEARNIMG_H
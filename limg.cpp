@@ -0,0 +1,452 @@
+#include <iostream>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <vector>
+#include "limg.h"
+
+namespace {
+
+// Buffered byte sink; ostream::put per byte is far too slow for large images
+class ByteWriter {
+public:
+    explicit ByteWriter(std::ostream &s) : out(s) {}
+    ~ByteWriter() { flush(); }
+
+    void put(unsigned char c)
+    {
+        if (len == sizeof(buf)) flush();
+        buf[len++] = static_cast<char>(c);
+    }
+
+    void putVarint(uint64_t v)
+    {
+        while (v >= 0x80) {
+            put(static_cast<unsigned char>((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        put(static_cast<unsigned char>(v));
+    }
+
+    void putU32(uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i) put(static_cast<unsigned char>(v >> (8 * i)));
+    }
+
+    void putBytes(const unsigned char *p, size_t n)
+    {
+        while (n > 0) {
+            if (len == sizeof(buf)) flush();
+            const size_t chunk = std::min(n, static_cast<size_t>(sizeof(buf) - len));
+            std::memcpy(buf + len, p, chunk);
+            len += static_cast<std::streamsize>(chunk);
+            p += chunk;
+            n -= chunk;
+        }
+    }
+
+    void flush()
+    {
+        if (len) out.write(buf, len);
+        len = 0;
+    }
+
+private:
+    std::ostream &out;
+    char buf[1 << 16];
+    std::streamsize len = 0;
+};
+
+// Reads straight from the streambuf so nothing past the end of the image is consumed
+// (several LIMG images may follow each other in one stream)
+class ByteReader {
+public:
+    explicit ByteReader(std::istream &s) : in(s), sb(s.rdbuf()) {}
+
+    // Returns -1 at end of stream
+    int get()
+    {
+        const auto c = sb->sbumpc();
+        if (c == std::char_traits<char>::eof()) {
+            in.setstate(std::ios::eofbit | std::ios::failbit);
+            return -1;
+        }
+        return static_cast<unsigned char>(c);
+    }
+
+    bool getVarint(uint64_t &v)
+    {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const int c = get();
+            if (c < 0) return false;
+            v |= static_cast<uint64_t>(c & 0x7F) << shift;
+            if (!(c & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool getBytes(unsigned char *p, size_t n)
+    {
+        if (static_cast<size_t>(sb->sgetn(reinterpret_cast<char*>(p), static_cast<std::streamsize>(n))) == n) return true;
+        in.setstate(std::ios::eofbit | std::ios::failbit);
+        return false;
+    }
+
+    bool getU32(uint32_t &v)
+    {
+        v = 0;
+        for (int i = 0; i < 4; ++i) {
+            const int c = get();
+            if (c < 0) return false;
+            v |= static_cast<uint32_t>(c) << (8 * i);
+        }
+        return true;
+    }
+
+private:
+    std::istream &in;
+    std::streambuf *sb;
+};
+
+void writeHeader(ByteWriter &w, const char *magic, int width, int height)
+{
+    for (int i = 0; i < 4; ++i) w.put(static_cast<unsigned char>(magic[i]));
+    w.putU32(static_cast<uint32_t>(width));
+    w.putU32(static_cast<uint32_t>(height));
+}
+
+// Reads the 12 byte header; magic receives the 4 magic characters
+bool readHeader(ByteReader &r, char magic[5], int &width, int &height)
+{
+    for (int i = 0; i < 4; ++i) {
+        const int c = r.get();
+        if (c < 0) return false;
+        magic[i] = static_cast<char>(c);
+    }
+    magic[4] = '\0';
+    uint32_t w = 0, h = 0;
+    if (!r.getU32(w) || !r.getU32(h)) return false;
+    // Pixel indices are ints throughout the project
+    if (w == 0 || h == 0 || static_cast<uint64_t>(w) * h > static_cast<uint64_t>(INT_MAX)) return false;
+    width = static_cast<int>(w);
+    height = static_cast<int>(h);
+    return true;
+}
+
+const size_t maxRawSpan = 4096;  // approximate pixels per LIM5 RAW op
+const size_t minSpanBreak = 4;   // repeats that end a span and are sent as a RUN op
+
+size_t varintBytes(uint64_t v)
+{
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+void putGrayRun(ByteWriter &w, uint64_t run)
+{
+    if (run > 64) {
+        w.put(0xFE);
+        w.putVarint(run - 65);
+    } else if (run > 0) {
+        w.put(static_cast<unsigned char>(run - 1));
+    }
+}
+
+void putRgbRun(ByteWriter &w, uint64_t run)
+{
+    if (run > 61) {
+        w.put(0xFD);
+        w.putVarint(run - 62);
+    } else if (run > 0) {
+        w.put(static_cast<unsigned char>(0xC0 + run - 1));
+    }
+}
+
+inline int colorHash(unsigned char r, unsigned char g, unsigned char b)
+{
+    return (r * 3 + g * 5 + b * 7) & 63;
+}
+
+// Decodes a LIM5 body into dst (count bytes)
+bool decodeGrayBody(ByteReader &r, unsigned char *dst, size_t count)
+{
+    unsigned char prev = 0;
+    size_t i = 0;
+    while (i < count) {
+        const int op = r.get();
+        if (op < 0) return false;
+        if (op < 0x40) {
+            const size_t run = static_cast<size_t>(op) + 1;
+            if (run > count - i) return false;
+            std::memset(dst + i, prev, run);
+            i += run;
+        } else if (op < 0xC0) {
+            prev = static_cast<unsigned char>(prev + (op - 0x40 - 64));
+            dst[i++] = prev;
+        } else if (op == 0xFE) {
+            uint64_t n = 0;
+            if (!r.getVarint(n) || n + 65 > count - i) return false;
+            std::memset(dst + i, prev, n + 65);
+            i += n + 65;
+        } else if (op == 0xFF) {
+            const int c = r.get();
+            if (c < 0) return false;
+            prev = static_cast<unsigned char>(c);
+            dst[i++] = prev;
+        } else if (op == 0xFD) {
+            uint64_t n = 0;
+            if (!r.getVarint(n) || n + 1 > count - i || !r.getBytes(dst + i, n + 1)) return false;
+            i += n + 1;
+            prev = dst[i - 1];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+void encodeLimg(std::ostream &s, const P5 &img)
+{
+    ByteWriter w(s);
+    writeHeader(w, "LIM5", img.width, img.height);
+    const size_t count = static_cast<size_t>(img.width) * static_cast<size_t>(img.height);
+    const unsigned char *src = img.img_data;
+    unsigned char ops[2 * maxRawSpan + 2 * minSpanBreak];
+    unsigned char prev = 0;
+    size_t i = 0;
+    while (i < count) {
+        if (src[i] == prev) {
+            size_t j = i + 1;
+            while (j < count && src[j] == prev) ++j;
+            putGrayRun(w, j - i);
+            i = j;
+            continue;
+        }
+        // Span up to the next run of at least minSpanBreak repeats or about maxRawSpan pixels. Its ops are
+        // staged in ops[] and replaced by one RAW op when that is smaller, so noise stays near raw size.
+        // Shorter repeats stay inside the span as RUN ops: ending a span there could cost more (a new
+        // RAW header) than the run saves.
+        size_t end = i;
+        size_t len = 0;
+        for (;;) {
+            // Branch free: DIFF when c - prev is in -64..63 (biased fits in 7 bits), otherwise LITERAL;
+            // both bytes are always stored and len advances by 1 or 2
+            const unsigned char c = src[end++];
+            const unsigned char biased = static_cast<unsigned char>(c - prev + 64);
+            const unsigned literal = biased >> 7;
+            ops[len] = literal ? 0xFF : static_cast<unsigned char>(0x40 + biased);
+            ops[len + 1] = c;
+            len += 1 + literal;
+            prev = c;
+            if (end == count || end - i >= maxRawSpan) break;
+            if (src[end] == c) {
+                size_t r = 1;
+                while (r < minSpanBreak && end + r < count && src[end + r] == c) ++r;
+                if (r == minSpanBreak) break;
+                ops[len++] = static_cast<unsigned char>(r - 1);
+                end += r;
+                if (end == count || end - i >= maxRawSpan) break;
+            }
+        }
+        const size_t n = end - i;
+        if (len <= 2) {
+            w.put(ops[0]);
+            if (len == 2) w.put(ops[1]);
+        } else if (len > n + varintBytes(n - 1) + 1) {
+            w.put(0xFD);
+            w.putVarint(n - 1);
+            w.putBytes(src + i, n);
+        } else {
+            w.putBytes(ops, len);
+        }
+        i = end;
+    }
+}
+
+void encodeLimg(std::ostream &s, const P6 &img)
+{
+    ByteWriter w(s);
+    writeHeader(w, "LIM6", img.width, img.height);
+    const size_t count = static_cast<size_t>(img.width) * static_cast<size_t>(img.height);
+    unsigned char index[64][3];
+    std::memset(index, 0, sizeof(index));
+    unsigned char pr = 0, pg = 0, pb = 0;
+    uint64_t run = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned char r = img.r[i], g = img.g[i], b = img.b[i];
+        if (r == pr && g == pg && b == pb) {
+            ++run;
+            continue;
+        }
+        putRgbRun(w, run);
+        run = 0;
+
+        const int h = colorHash(r, g, b);
+        if (index[h][0] == r && index[h][1] == g && index[h][2] == b) {
+            w.put(static_cast<unsigned char>(h));
+        } else {
+            index[h][0] = r; index[h][1] = g; index[h][2] = b;
+            const int dr = static_cast<signed char>(static_cast<unsigned char>(r - pr));
+            const int dg = static_cast<signed char>(static_cast<unsigned char>(g - pg));
+            const int db = static_cast<signed char>(static_cast<unsigned char>(b - pb));
+            const int dr_dg = dr - dg, db_dg = db - dg;
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                w.put(static_cast<unsigned char>(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+            } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                w.put(static_cast<unsigned char>(0x80 | (dg + 32)));
+                w.put(static_cast<unsigned char>((dr_dg + 8) << 4 | (db_dg + 8)));
+            } else {
+                w.put(0xFE);
+                w.put(r); w.put(g); w.put(b);
+            }
+        }
+        pr = r; pg = g; pb = b;
+    }
+    putRgbRun(w, run);
+}
+
+void encodeLimg(std::ostream &s, const Pattern &p)
+{
+    ByteWriter w(s);
+    writeHeader(w, "LIMP", p.width, p.height);
+    const size_t count = static_cast<size_t>(p.width) * static_cast<size_t>(p.height);
+    const bool *src = p.data;
+    bool value = false;
+    size_t i = 0;
+    while (i < count) {
+        size_t j = i;
+        while (j < count && src[j] == value) ++j;
+        w.putVarint(j - i);
+        i = j;
+        value = !value;
+    }
+}
+
+std::unique_ptr<P5> decodeLimgP5(std::istream &s)
+{
+    ByteReader r(s);
+    char magic[5];
+    int width = 0, height = 0;
+    if (!readHeader(r, magic, width, height) || std::strcmp(magic, "LIM5") != 0) {
+        std::cerr << "Invalid LIMG header (expected LIM5)\n";
+        return nullptr;
+    }
+    std::unique_ptr<P5> img(new P5(width, height));
+    if (!decodeGrayBody(r, img->img_data, static_cast<size_t>(width) * height)) {
+        std::cerr << "Corrupt or truncated LIM5 data\n";
+        return nullptr;
+    }
+    return img;
+}
+
+std::unique_ptr<P6> decodeLimgP6(std::istream &s)
+{
+    ByteReader rd(s);
+    char magic[5];
+    int width = 0, height = 0;
+    if (!readHeader(rd, magic, width, height) || std::strcmp(magic, "LIM6") != 0) {
+        std::cerr << "Invalid LIMG header (expected LIM6)\n";
+        return nullptr;
+    }
+    std::unique_ptr<P6> img(new P6(width, height));
+    const size_t count = static_cast<size_t>(width) * height;
+    unsigned char index[64][3];
+    std::memset(index, 0, sizeof(index));
+    unsigned char r = 0, g = 0, b = 0;
+    size_t i = 0;
+    while (i < count) {
+        const int op = rd.get();
+        if (op < 0) break;
+        size_t run = 1;
+        if (op < 0x40) {
+            r = index[op][0]; g = index[op][1]; b = index[op][2];
+        } else if (op < 0x80) {
+            r = static_cast<unsigned char>(r + ((op >> 4) & 3) - 2);
+            g = static_cast<unsigned char>(g + ((op >> 2) & 3) - 2);
+            b = static_cast<unsigned char>(b + (op & 3) - 2);
+        } else if (op < 0xC0) {
+            const int next = rd.get();
+            if (next < 0) break;
+            const int dg = (op & 0x3F) - 32;
+            r = static_cast<unsigned char>(r + dg + (next >> 4) - 8);
+            g = static_cast<unsigned char>(g + dg);
+            b = static_cast<unsigned char>(b + dg + (next & 0x0F) - 8);
+        } else if (op <= 0xFC) {
+            run = static_cast<size_t>(op - 0xC0) + 1;
+        } else if (op == 0xFD) {
+            uint64_t n = 0;
+            if (!rd.getVarint(n)) break;
+            run = n + 62;
+        } else if (op == 0xFE) {
+            const int cr = rd.get(), cg = rd.get(), cb = rd.get();
+            if (cb < 0) break;
+            r = static_cast<unsigned char>(cr);
+            g = static_cast<unsigned char>(cg);
+            b = static_cast<unsigned char>(cb);
+        } else {
+            break;
+        }
+        if (run > count - i) break;
+        if (op < 0xC0 || op == 0xFE) {
+            const int h = colorHash(r, g, b);
+            index[h][0] = r; index[h][1] = g; index[h][2] = b;
+        }
+        std::memset(img->r + i, r, run);
+        std::memset(img->g + i, g, run);
+        std::memset(img->b + i, b, run);
+        i += run;
+    }
+    if (i != count) {
+        std::cerr << "Corrupt or truncated LIM6 data\n";
+        return nullptr;
+    }
+    return img;
+}
+
+Pattern decodeLimgPattern(std::istream &s)
+{
+    ByteReader r(s);
+    char magic[5];
+    int width = 0, height = 0;
+    if (!readHeader(r, magic, width, height)) {
+        std::cerr << "Invalid LIMG header\n";
+        return Pattern(1,1);
+    }
+    const size_t count = static_cast<size_t>(width) * height;
+    Pattern p(width, height);
+
+    if (std::strcmp(magic, "LIM5") == 0) {
+        std::vector<unsigned char> gray(count);
+        if (!decodeGrayBody(r, gray.data(), count)) {
+            std::cerr << "Corrupt or truncated LIM5 data\n";
+            return Pattern(1,1);
+        }
+        for (size_t i = 0; i < count; ++i) p.data[i] = gray[i] != 0;
+        return p;
+    }
+    if (std::strcmp(magic, "LIMP") != 0) {
+        std::cerr << "Unsupported LIMG magic: " << magic << " (expected LIMP or LIM5)\n";
+        return Pattern(1,1);
+    }
+
+    bool value = false;
+    size_t i = 0;
+    while (i < count) {
+        uint64_t run = 0;
+        if (!r.getVarint(run) || run > count - i) {
+            std::cerr << "Corrupt or truncated LIMP data\n";
+            return Pattern(1,1);
+        }
+        std::memset(p.data + i, value, run);
+        i += run;
+        value = !value;
+    }
+    return p;
+}
@@ -0,0 +1,47 @@
+#ifndef LIMG_H
+#define LIMG_H
+
+// LIMG: small lossless codec for the synthetic images this project produces.
+//
+// Every stream starts with a 12 byte header: 4 byte magic ("LIM5" grayscale, "LIM6" RGB, "LIMP" Pattern)
+// followed by width and height as little-endian uint32. The body depends on the magic:
+//
+//   LIM5  one op per pixel run, relative to the previous gray value (starts at 0)
+//         0x00..0x3F  RUN       repeat previous value 1..64 times
+//         0x40..0xBF  DIFF      previous value + (op - 0x40 - 64), i.e. -64..63 (wraps mod 256)
+//         0xFD        RAW       varint n follows, then n + 1 raw bytes (the last one becomes the previous value)
+//         0xFE        LONG RUN  varint n follows, repeat previous value n + 65 times
+//         0xFF        LITERAL   one raw byte follows
+//         The encoder uses RAW for stretches where the other ops would be larger, so incompressible
+//         images grow by at most a few bytes per 4096 pixels (under 0.1%).
+//
+//   LIM6  QOI-like ops relative to the previous pixel (starts at 0,0,0) and a 64 entry color index
+//         0x00..0x3F  INDEX     color index[op]
+//         0x40..0x7F  DIFF      dr, dg, db in -2..1, two bits each
+//         0x80..0xBF  LUMA      dg = (op & 0x3F) - 32, next byte (dr - dg + 8) << 4 | (db - dg + 8)
+//         0xC0..0xFC  RUN       repeat previous pixel 1..61 times
+//         0xFD        LONG RUN  varint n follows, repeat previous pixel n + 62 times
+//         0xFE        RGB       three raw bytes follow
+//
+//   LIMP  alternating run lengths as varints (LEB128), starting with a run of false pixels (may be 0)
+//
+// Varints are LEB128 (7 bits per byte, low bits first). Encoders and decoders stream through a fixed
+// size buffer, so memory use does not grow with the image.
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include "pgm.h"
+#include "pattern.h"
+
+void encodeLimg(std::ostream &s, const P5 &img);
+void encodeLimg(std::ostream &s, const P6 &img);
+void encodeLimg(std::ostream &s, const Pattern &p);
+
+// Decoders return nullptr (or a 1x1 Pattern, like loadPatternFromPgm) and print to std::cerr on malformed input
+std::unique_ptr<P5> decodeLimgP5(std::istream &s);
+std::unique_ptr<P6> decodeLimgP6(std::istream &s);
+// Accepts "LIMP" and "LIM5" streams (non-zero gray -> true)
+Pattern decodeLimgPattern(std::istream &s);
+
+#endif // LIMG_H
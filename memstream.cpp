@@ -0,0 +1,67 @@
+#include "memstream.h"
+
+MemoryOStream::MemoryOStream(unsigned char *buffer, size_t capacity)
+    : std::ostream(nullptr), buf(reinterpret_cast<char*>(buffer), capacity)
+{
+    rdbuf(&buf);
+}
+
+size_t MemoryOStream::size() const
+{
+    return buf.written();
+}
+
+MemoryIStream::MemoryIStream(const unsigned char *data, size_t size)
+    // std::streambuf wants char *, but the get area is never written through
+    : std::istream(nullptr), buf(const_cast<char*>(reinterpret_cast<const char*>(data)), size)
+{
+    rdbuf(&buf);
+}
+
+namespace {
+
+// Appends to a std::vector<unsigned char>
+struct VectorBuf : std::streambuf {
+    explicit VectorBuf(std::vector<unsigned char> &v) : out(v) {}
+
+    int_type overflow(int_type c) override
+    {
+        if (c != traits_type::eof()) out.push_back(static_cast<unsigned char>(c));
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        out.insert(out.end(), reinterpret_cast<const unsigned char*>(s), reinterpret_cast<const unsigned char*>(s) + n);
+        return n;
+    }
+
+    std::vector<unsigned char> &out;
+};
+
+} // namespace
+
+size_t encodePatternToMemory(const Pattern &p, unsigned char *dst, size_t capacity, ImageFormat format)
+{
+    MemoryOStream s(dst, capacity);
+    writePatternAsPgm(s, p, format);
+    s.flush();
+    return s ? s.size() : 0;
+}
+
+std::vector<unsigned char> encodePatternToVector(const Pattern &p, ImageFormat format)
+{
+    std::vector<unsigned char> bytes;
+    // Raw P5 size is known up front; LIMG output is usually much smaller
+    bytes.reserve(format == ImageFormat::Netpbm ? static_cast<size_t>(p.width) * p.height + 32 : 4096);
+    VectorBuf vb(bytes);
+    std::ostream s(&vb);
+    writePatternAsPgm(s, p, format);
+    return bytes;
+}
+
+Pattern decodePatternFromMemory(const unsigned char *data, size_t size)
+{
+    MemoryIStream s(data, size);
+    return readPatternFromPgm(s);
+}
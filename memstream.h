@@ -0,0 +1,46 @@
+#ifndef MEMSTREAM_H
+#define MEMSTREAM_H
+
+// Streams over caller-owned memory, so every stream encoder/decoder (writePatternAsPgm, encodeLimg,
+// readPatternFromPgm, ...) can target RAM without temp files or intermediate copies.
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+#include "pattern.h"
+
+// Writes into [buffer, buffer + capacity); the stream goes bad instead of overflowing
+class MemoryOStream : public std::ostream {
+public:
+    MemoryOStream(unsigned char *buffer, size_t capacity);
+    // Bytes written so far
+    size_t size() const;
+
+private:
+    struct Buf : std::streambuf {
+        Buf(char *b, size_t n) { setp(b, b + n); }
+        size_t written() const { return static_cast<size_t>(pptr() - pbase()); }
+    } buf;
+};
+
+// Reads from [data, data + size) without copying it
+class MemoryIStream : public std::istream {
+public:
+    MemoryIStream(const unsigned char *data, size_t size);
+
+private:
+    struct Buf : std::streambuf {
+        Buf(char *b, size_t n) { setg(b, b, b + n); }
+    } buf;
+};
+
+// Encodes p into dst; returns the number of bytes written, or 0 if it does not fit in capacity
+size_t encodePatternToMemory(const Pattern &p, unsigned char *dst, size_t capacity, ImageFormat format = ImageFormat::Netpbm);
+// Encodes p into a growing byte vector
+std::vector<unsigned char> encodePatternToVector(const Pattern &p, ImageFormat format = ImageFormat::Netpbm);
+// Decodes a P5 PGM or LIMG image held in memory
+Pattern decodePatternFromMemory(const unsigned char *data, size_t size);
+
+#endif // MEMSTREAM_H
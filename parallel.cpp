@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "parallel.h"
+
+int defaultThreadCount()
+{
+    const unsigned n = std::thread::hardware_concurrency();
+    return n ? static_cast<int>(n) : 1;
+}
+
+namespace {
+
+// Set while the current thread is executing a parallelFor; nested calls then run inline
+thread_local bool insideParallelFor = false;
+
+// Spawns threads for one call; used when the shared pool is busy with another caller
+void runSpawned(int count, const std::function<void(int)> &body, int threads)
+{
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        insideParallelFor = true;
+        for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) body(i);
+        insideParallelFor = false;
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto &th : pool) th.join();
+}
+
+// Long-lived workers (defaultThreadCount() - 1 of them) so repeated calls, e.g. per request in
+// a server, do not pay for thread creation. Serves one parallelFor at a time.
+class WorkerPool {
+public:
+    WorkerPool()
+    {
+        for (int t = 1; t < defaultThreadCount(); ++t) workers.emplace_back([this]() { workerLoop(); });
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto &th : workers) th.join();
+    }
+
+    int size() const { return static_cast<int>(workers.size()); }
+
+    // Returns false without doing anything if another thread is currently using the pool
+    bool tryRun(int count, const std::function<void(int)> &fn, int threads)
+    {
+        std::unique_lock<std::mutex> owner(runMutex, std::try_to_lock);
+        if (!owner.owns_lock()) return false;
+
+        {
+            std::lock_guard<std::mutex> lock(m);
+            body = &fn;
+            total = count;
+            next.store(0);
+            slots = threads - 1;
+            ++generation;
+        }
+        wake.notify_all();
+
+        insideParallelFor = true;
+        for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) fn(i);
+        insideParallelFor = false;
+
+        std::unique_lock<std::mutex> lock(m);
+        slots = 0; // workers that have not picked this job up yet stay out
+        done.wait(lock, [this]() { return active == 0; });
+        body = nullptr;
+        return true;
+    }
+
+private:
+    void workerLoop()
+    {
+        insideParallelFor = true;
+        unsigned long seen = 0;
+        std::unique_lock<std::mutex> lock(m);
+        for (;;) {
+            wake.wait(lock, [&]() { return stop || generation != seen; });
+            if (stop) return;
+            seen = generation;
+            if (slots <= 0) continue;
+            --slots;
+            ++active;
+            const std::function<void(int)> *fn = body;
+            const int count = total;
+            lock.unlock();
+            for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) (*fn)(i);
+            lock.lock();
+            if (--active == 0) done.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex runMutex;
+    std::mutex m;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)> *body = nullptr;
+    int total = 0;
+    std::atomic<int> next{0};
+    int slots = 0;
+    int active = 0;
+    unsigned long generation = 0;
+    bool stop = false;
+};
+
+WorkerPool &sharedPool()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+} // namespace
+
+void parallelFor(int count, const std::function<void(int)> &body, int threads)
+{
+    if (count <= 0) return;
+    if (threads <= 0) threads = defaultThreadCount();
+    threads = std::min(threads, count);
+    if (threads == 1 || insideParallelFor) {
+        for (int i = 0; i < count; ++i) body(i);
+        return;
+    }
+
+    WorkerPool &pool = sharedPool();
+    if (threads - 1 <= pool.size() && pool.tryRun(count, body, threads)) return;
+    runSpawned(count, body, threads);
+}
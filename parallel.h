@@ -0,0 +1,14 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <functional>
+
+// Number of worker threads used when a caller passes threads <= 0 (hardware concurrency, at least 1)
+int defaultThreadCount();
+
+// Runs body(i) for every i in [0, count), handing indices out dynamically to up to `threads` workers.
+// The calling thread takes part; returns once every index has been processed. Workers come from a
+// process-wide pool that stays alive between calls; nested calls run inline on the calling thread.
+void parallelFor(int count, const std::function<void(int)> &body, int threads = 0);
+
+#endif // PARALLEL_H
@@ -2,8 +2,13 @@
 #include <fstream>
 #include <cstdint>
 #include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cassert>
 #include "pgm.h"
 #include "pattern.h"
+#include "limg.h"
 
 #include <cstring> // for std::memset
 
@@ -14,26 +19,72 @@ Pattern::Pattern(int w, int h) : width(w), height(h)
     std::memset(data, 0, width * height * sizeof(bool));
 }
 
+Pattern::Pattern(int w, int h, bool *buffer) : width(w), height(h), data(buffer), ownsData(false)
+{
+}
+
 Pattern::Pattern(const Pattern& other) : width(other.width), height(other.height)
 {
     data = new bool[width * height];
-    for (int i = 0; i < width * height; ++i) data[i] = other.data[i];
+    std::memcpy(data, other.data, width * height * sizeof(bool));
+}
+
+Pattern::Pattern(Pattern&& other) noexcept : width(other.width), height(other.height), data(other.data), ownsData(other.ownsData)
+{
+    other.width = 0;
+    other.height = 0;
+    other.data = nullptr;
+    other.ownsData = true;
+}
+
+// A wrapper must keep writing into the caller's buffer, so it only accepts patterns of its own size
+static bool wrapperSizeMatches(const Pattern &dst, const Pattern &src)
+{
+    if (dst.width == src.width && dst.height == src.height) return true;
+    std::cerr << "Cannot assign a " << src.width << "x" << src.height << " Pattern to a wrapped "
+              << dst.width << "x" << dst.height << " buffer; left unchanged" << std::endl;
+    assert(!"size mismatch on assignment to a wrapping Pattern");
+    return false;
 }
 
 Pattern& Pattern::operator=(const Pattern& other)
 {
-    if (this != &other) {
+    if (this == &other) return *this;
+    if (!ownsData) {
+        if (wrapperSizeMatches(*this, other)) std::memcpy(data, other.data, width * height * sizeof(bool));
+        return *this;
+    }
+    if (width != other.width || height != other.height) {
         delete[] data;
         width = other.width;
         height = other.height;
         data = new bool[width * height];
-        for (int i = 0; i < width * height; ++i) data[i] = other.data[i];
     }
+    std::memcpy(data, other.data, width * height * sizeof(bool));
     return *this;
 }
 
-Pattern::~Pattern() {
+Pattern& Pattern::operator=(Pattern&& other) noexcept
+{
+    if (this == &other) return *this;
+    if (!ownsData) {
+        if (wrapperSizeMatches(*this, other)) std::memcpy(data, other.data, width * height * sizeof(bool));
+        return *this;
+    }
     delete[] data;
+    width = other.width;
+    height = other.height;
+    data = other.data;
+    ownsData = other.ownsData;
+    other.width = 0;
+    other.height = 0;
+    other.data = nullptr;
+    other.ownsData = true;
+    return *this;
+}
+
+Pattern::~Pattern() {
+    if (ownsData) delete[] data;
 }
 
 Pattern Pattern::operator&&(const Pattern &other) const {
@@ -60,25 +111,29 @@ Pattern Pattern::operator^(const Pattern &other) const {
     return result;
 }
 
-void Pattern::saveAsPgm(const char *filename) const {
-    P5 img(width, height);
-    for (int i = 0; i < width * height; ++i) img.img_data[i] = data[i] ? 255 : 0;
-    std::string out_path = std::string("./patterns/") + filename;
-    std::ofstream file(out_path.c_str(), std::ios::out | std::ios::binary);
-    if (!file) { std::cerr << "Failed to open " << out_path << " for writing\n"; return; }
-    file << img;
-    if (!file) std::cerr << "Failed while writing " << filename << "\n";
+void Pattern::saveAsPgm(const char *filename, ImageFormat format) const {
+    savePatternAsPgm(*this, filename, format);
 }
 
-// Free function wrapper to save a Pattern (declared in pattern.h)
-void savePatternAsPgm(const Pattern &p, const char *filename)
+void writePatternAsPgm(std::ostream &s, const Pattern &p, ImageFormat format)
 {
+    if (format == ImageFormat::Limg)
+    {
+        // Masks are stored as bit runs (LIMP), no need to expand to 8-bit gray first
+        encodeLimg(s, p);
+        return;
+    }
     P5 img(p.width, p.height);
     for (int i = 0; i < p.width * p.height; ++i)
     {
         img.img_data[i] = p.data[i] ? 255 : 0;
     }
+    s << img;
+}
 
+// Free function wrapper to save a Pattern (declared in pattern.h)
+void savePatternAsPgm(const Pattern &p, const char *filename, ImageFormat format)
+{
     std::string out_path = std::string("./patterns/") + filename;
     std::ofstream file(out_path.c_str(), std::ios::out | std::ios::binary);
     if (!file)
@@ -87,7 +142,7 @@ void savePatternAsPgm(const Pattern &p, const char *filename)
         return;
     }
 
-    file << img;
+    writePatternAsPgm(file, p, format);
     if (!file)
     {
         std::cerr << "Failed while writing " << filename << "\n";
@@ -97,6 +152,14 @@ void savePatternAsPgm(const Pattern &p, const char *filename)
 Pattern generateCirclePattern(int width, int height, int radius)
 {
     Pattern pattern(width, height);
+    fillCirclePattern(pattern, radius);
+    return pattern;
+}
+
+void fillCirclePattern(Pattern &pattern, int radius)
+{
+    const int width = pattern.width;
+    const int height = pattern.height;
     const int centerX = width / 2;
     const int centerY = height / 2;
     for (int y = 0; y < height; y++)
@@ -108,12 +171,19 @@ Pattern generateCirclePattern(int width, int height, int radius)
             pattern.data[y * width + x] = (dx * dx + dy * dy <= radius * radius);
         }
     }
-    return pattern;
 }
 
 Pattern generateTrianglePattern(int width, int height)
 {
     Pattern pattern(width, height);
+    fillTrianglePattern(pattern);
+    return pattern;
+}
+
+void fillTrianglePattern(Pattern &pattern)
+{
+    const int width = pattern.width;
+    const int height = pattern.height;
     for (int y = 0; y < height; y++)
     {
         for (int x = 0; x < width; x++)
@@ -121,12 +191,19 @@ Pattern generateTrianglePattern(int width, int height)
             pattern.data[y * width + x] = (x >= (width / 2 - (y * width) / (2 * height)) && x <= (width / 2 + (y * width) / (2 * height)));
         }
     }
-    return pattern;
 }
 
 Pattern generateCheckerboardPattern(int width, int height, int squareSize)
 {
     Pattern pattern(width, height);
+    fillCheckerboardPattern(pattern, squareSize);
+    return pattern;
+}
+
+void fillCheckerboardPattern(Pattern &pattern, int squareSize)
+{
+    const int width = pattern.width;
+    const int height = pattern.height;
     for (int y = 0; y < height; y++)
     {
         for (int x = 0; x < width; x++)
@@ -136,13 +213,13 @@ Pattern generateCheckerboardPattern(int width, int height, int squareSize)
             pattern.data[y * width + x] = ((xSquare + ySquare) % 2 == 0);
         }
     }
-    return pattern;
 }
 
-// Generates a grayscale PGM image of a shaded 3D ball (sphere)
-void generate3DBallPgm(int width, int height, const char* filename = "3d_ball.pgm")
+// Renders a shaded 3D ball (sphere) into img
+void render3DBall(P5 &img)
 {
-    P5 img(width, height);
+    const int width = img.width;
+    const int height = img.height;
     int cx = width / 2;
     int cy = height / 2;
     int radius = std::min(width, height) / 2 - 4;
@@ -182,6 +259,19 @@ void generate3DBallPgm(int width, int height, const char* filename = "3d_ball.pg
             }
         }
     }
+}
+
+void write3DBallPgm(std::ostream &s, int width, int height, ImageFormat format)
+{
+    P5 img(width, height);
+    render3DBall(img);
+    if (format == ImageFormat::Limg) encodeLimg(s, img);
+    else s << img;
+}
+
+// Generates a grayscale PGM image of a shaded 3D ball (sphere)
+void generate3DBallPgm(int width, int height, const char* filename = "3d_ball.pgm", ImageFormat format)
+{
     std::string out_path = std::string("./patterns/") + filename;
     std::ofstream file(out_path.c_str(), std::ios::out | std::ios::binary);
     if (!file)
@@ -189,44 +279,49 @@ void generate3DBallPgm(int width, int height, const char* filename = "3d_ball.pg
         std::cerr << "Failed to open " << out_path << " for writing\n";
         return;
     }
-    file << img;
+    write3DBallPgm(file, width, height, format);
     if (!file)
     {
         std::cerr << "Failed while writing " << filename << "\n";
     }
 }
 
-void patternMixer(Pattern r, Pattern g, Pattern b, int base_value, const char *filename = "pattern_mixer.ppm")
+void mixPatterns(P6 &img, const Pattern &r, const Pattern &g, const Pattern &b, int base_value)
 {
-    P6 img(r.width, r.height);
     for (int y = 0; y < img.height; y++)
     {
         for (int x = 0; x < img.width; x++)
         {
-            img.r[y * img.width + x] = r.data[y * img.width + x] ? base_value : 0;
-            img.g[y * img.width + x] = g.data[y * img.width + x] ? base_value : 0;
-            img.b[y * img.width + x] = b.data[y * img.width + x] ? base_value : 0;
+            img.r[y * img.width + x] = r.data[y * r.width + x] ? base_value : 0;
+            img.g[y * img.width + x] = g.data[y * g.width + x] ? base_value : 0;
+            img.b[y * img.width + x] = b.data[y * b.width + x] ? base_value : 0;
         }
     }
+}
+
+void writePatternMixer(std::ostream &s, const Pattern &r, const Pattern &g, const Pattern &b, int base_value, ImageFormat format)
+{
+    P6 img(r.width, r.height);
+    mixPatterns(img, r, g, b, base_value);
+    if (format == ImageFormat::Limg) encodeLimg(s, img);
+    else s << img;
+}
 
+void patternMixer(Pattern r, Pattern g, Pattern b, int base_value, const char *filename = "pattern_mixer.ppm", ImageFormat format)
+{
     std::string out_path = std::string("./patterns/") + filename;
     std::ofstream file(out_path.c_str(), std::ios::out | std::ios::binary);
     if (!file) {
         std::cerr << "Failed to open " << out_path << " for writing\n";
         return;
     }
-    file << img;
+    writePatternMixer(file, r, g, b, base_value, format);
 }
 
-// Load a P5 PGM from the patterns folder and convert to a boolean Pattern (non-zero -> true)
-Pattern loadPatternFromPgm(const char *filename)
+// Read a P5 PGM (or a LIMP/LIM5 LIMG image) from a stream and convert to a boolean Pattern (non-zero -> true)
+Pattern readPatternFromPgm(std::istream &file)
 {
-    std::string in_path = std::string("./patterns/") + filename;
-    std::ifstream file(in_path.c_str(), std::ios::in | std::ios::binary);
-    if (!file) {
-        std::cerr << "Failed to open " << in_path << " for reading\n";
-        return Pattern(1,1);
-    }
+    if (file.peek() == 'L') return decodeLimgPattern(file);
 
     std::string magic;
     file >> magic;
@@ -247,42 +342,73 @@ Pattern loadPatternFromPgm(const char *filename)
     file.get(); // skip single whitespace
 
     if (width <= 0 || height <= 0) {
-        std::cerr << "Invalid dimensions in " << in_path << "\n";
+        std::cerr << "Invalid PGM dimensions " << width << "x" << height << "\n";
         return Pattern(1,1);
     }
 
+    // Read the gray bytes straight into the Pattern, then normalize them to 0/1 in place
     Pattern p(width, height);
-    std::vector<unsigned char> buffer(width * height);
-    file.read(reinterpret_cast<char*>(buffer.data()), width * height);
+    unsigned char *bytes = reinterpret_cast<unsigned char*>(p.data);
+    file.read(reinterpret_cast<char*>(bytes), width * height);
     if (!file) {
-        std::cerr << "Failed while reading image data from " << in_path << "\n";
+        std::cerr << "Failed while reading PGM image data\n";
         return Pattern(1,1);
     }
     for (int i = 0; i < width * height; ++i) {
-        p.data[i] = buffer[i] != 0;
+        bytes[i] = bytes[i] != 0;
     }
     return p;
 }
 
-Pattern labyrinthPatternGenerator(Pattern &basePattern, Pattern &visited, int x, int y)
+// Load a P5 PGM (or a LIMP/LIM5 LIMG file) from the patterns folder and convert to a boolean Pattern (non-zero -> true)
+Pattern loadPatternFromPgm(const char *filename)
 {
-    visited.data[y * basePattern.width + x] = true;
-    // Directions: up, right, down, left
-    int directions[4][2] = { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
-    // Shuffle directions for randomness
-    for (int i = 3; i > 0; --i) {
-        int j = rand() % (i + 1);
-        std::swap(directions[i], directions[j]);
+    std::string in_path = std::string("./patterns/") + filename;
+    std::ifstream file(in_path.c_str(), std::ios::in | std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << in_path << " for reading\n";
+        return Pattern(1,1);
     }
-    for (int d = 0; d < 4; ++d)
+    return readPatternFromPgm(file);
+}
+
+Pattern labyrinthPatternGenerator(Pattern &basePattern, Pattern &visited, int x, int y)
+{
+    // Depth-first carving with an explicit stack; recursion overflowed the call stack on large mazes
+    struct Frame {
+        int x, y;
+        int directions[4][2];
+        int next;
+    };
+    std::vector<Frame> stack;
+    auto enter = [&](int cx, int cy) {
+        visited.data[cy * basePattern.width + cx] = true;
+        // Directions: up, right, down, left
+        Frame f = { cx, cy, { {0, -1}, {1, 0}, {0, 1}, {-1, 0} }, 0 };
+        // Shuffle directions for randomness
+        for (int i = 3; i > 0; --i) {
+            int j = rand() % (i + 1);
+            std::swap(f.directions[i], f.directions[j]);
+        }
+        stack.push_back(f);
+    };
+    enter(x, y);
+    while (!stack.empty())
     {
-        int nx = x + directions[d][0] * 2;
-        int ny = y + directions[d][1] * 2;
+        Frame &f = stack.back();
+        if (f.next == 4) {
+            stack.pop_back();
+            continue;
+        }
+        const int dx = f.directions[f.next][0], dy = f.directions[f.next][1];
+        ++f.next;
+        int nx = f.x + dx * 2;
+        int ny = f.y + dy * 2;
         if (nx >= 0 && nx < basePattern.width && ny >= 0 && ny < basePattern.height && !visited.data[ny * basePattern.width + nx])
         {
             // Remove wall between current and next cell
-            basePattern.data[(y + directions[d][1]) * basePattern.width + (x + directions[d][0])] = true;
-            labyrinthPatternGenerator(basePattern, visited, nx, ny);
+            basePattern.data[(f.y + dy) * basePattern.width + (f.x + dx)] = true;
+            enter(nx, ny);
         }
     }
     return basePattern;
@@ -1,32 +1,61 @@
 #ifndef PATTERN_H
 #define PATTERN_H
 
+#include <iosfwd>
+#include "pgm.h"
+
 struct Pattern {
     int width;
     int height;
     bool *data;
+    bool ownsData = true;
     Pattern(int w, int h);
+    // Wraps a caller-owned buffer of w * h bools without copying; the caller keeps it alive
+    Pattern(int w, int h, bool *buffer);
+    // Copies are always owning. Assigning (copy or move) to a wrapper copies into the caller's buffer and
+    // requires the same size: a mismatch asserts, or with NDEBUG is reported on std::cerr and ignored.
+    // To render a different size, wrap a new buffer or use the fill* functions below.
     Pattern(const Pattern& other);
+    Pattern(Pattern&& other) noexcept;
     Pattern& operator=(const Pattern& other);
+    Pattern& operator=(Pattern&& other) noexcept;
     ~Pattern();
     Pattern operator&&(const Pattern &other) const;
     Pattern operator||(const Pattern &other) const;
     Pattern operator!() const;
     Pattern operator^(const Pattern &other) const;
-    void saveAsPgm(const char *filename) const;
+    void saveAsPgm(const char *filename, ImageFormat format = ImageFormat::Netpbm) const;
 };
 
 Pattern generateCirclePattern(int width, int height, int radius);
 Pattern generateTrianglePattern(int width, int height);
 Pattern generateCheckerboardPattern(int width, int height, int squareSize);
-void generate3DBallPgm(int width, int height, const char* filename);
-void patternMixer(Pattern r, Pattern g, Pattern b, int base_value, const char *filename);
+// format selects raw Netpbm output or the compact LIMG codec (limg.h). Despite the *Pgm names, with
+// ImageFormat::Limg these functions (and saveAsPgm/savePatternAsPgm) write LIMG, not PGM/PPM, to the
+// given filename; callers should pick a .limg extension for it.
+void generate3DBallPgm(int width, int height, const char* filename, ImageFormat format = ImageFormat::Netpbm);
+void patternMixer(Pattern r, Pattern g, Pattern b, int base_value, const char *filename, ImageFormat format = ImageFormat::Netpbm);
+
+// In-place variants: render into an existing (possibly caller-owned) Pattern/P5/P6 using its size
+void fillCirclePattern(Pattern &out, int radius);
+void fillTrianglePattern(Pattern &out);
+void fillCheckerboardPattern(Pattern &out, int squareSize);
+void render3DBall(P5 &out);
+// r, g, b must be at least as large as out
+void mixPatterns(P6 &out, const Pattern &r, const Pattern &g, const Pattern &b, int base_value);
+
+// Stream variants of the save/load functions; any std::ostream/std::istream works (files, sockets, memstream.h)
+void writePatternAsPgm(std::ostream &s, const Pattern &p, ImageFormat format = ImageFormat::Netpbm);
+void write3DBallPgm(std::ostream &s, int width, int height, ImageFormat format = ImageFormat::Netpbm);
+void writePatternMixer(std::ostream &s, const Pattern &r, const Pattern &g, const Pattern &b, int base_value, ImageFormat format = ImageFormat::Netpbm);
+// Reads a P5 PGM or LIMG (LIMP/LIM5) image; returns a 1x1 Pattern and reports to std::cerr on failure
+Pattern readPatternFromPgm(std::istream &s);
 
-// Load a binary P5 PGM file from ./patterns/ and convert to a Pattern (non-zero pixels -> true)
+// Load a binary P5 PGM (or LIMG, detected by magic) file from ./patterns/ and convert to a Pattern (non-zero pixels -> true)
 Pattern loadPatternFromPgm(const char *filename);
 Pattern labyrinthPatternGenerator(Pattern &basePattern, Pattern &visited, int x = 0, int y = 0);
 
 // Helper to save Pattern to file (implemented in pattern.cpp)
-void savePatternAsPgm(const Pattern &p, const char *filename);
+void savePatternAsPgm(const Pattern &p, const char *filename, ImageFormat format = ImageFormat::Netpbm);
 
 #endif // PATTERN_H
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <cstring>
+#include "pattern_stats.h"
+
+namespace {
+
+// Little-endian 64-bit load (byte-swapped on big-endian targets so hashes match everywhere)
+inline uint64_t load64le(const unsigned char *p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+inline const unsigned char *bytes(const Pattern &p)
+{
+    return reinterpret_cast<const unsigned char*>(p.data);
+}
+
+inline size_t pixelCount(const Pattern &p)
+{
+    return static_cast<size_t>(p.width) * static_cast<size_t>(p.height);
+}
+
+// Number of set pixels in a word of eight 0/1 bytes. Without a popcount instruction the libgcc
+// fallback is slow, so sum the bytes with one multiply instead (exact since the sum is <= 8).
+inline size_t pixelsInWord(uint64_t w)
+{
+#if defined(__POPCNT__) || defined(__ARM_NEON)
+    return static_cast<size_t>(__builtin_popcountll(w));
+#else
+    return static_cast<size_t>((w * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// Each pixel is a 0/1 byte, so 8 pixels are counted per 64-bit word
+size_t countRange(const unsigned char *p, size_t n)
+{
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) count += pixelsInWord(load64le(p + i));
+    for (; i < n; ++i) count += p[i];
+    return count;
+}
+
+size_t diffRange(const unsigned char *a, const unsigned char *b, size_t n)
+{
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) count += pixelsInWord(load64le(a + i) ^ load64le(b + i));
+    for (; i < n; ++i) count += a[i] ^ b[i];
+    return count;
+}
+
+bool anyRange(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) if (load64le(p + i)) return true;
+    for (; i < n; ++i) if (p[i]) return true;
+    return false;
+}
+
+inline uint64_t rotl(uint64_t v, int r)
+{
+    return (v << r) | (v >> (64 - r));
+}
+
+inline uint64_t fmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+} // namespace
+
+size_t countSetPixels(const Pattern &p)
+{
+    return countRange(bytes(p), pixelCount(p));
+}
+
+double coverage(const Pattern &p)
+{
+    const size_t n = pixelCount(p);
+    return n ? static_cast<double>(countSetPixels(p)) / static_cast<double>(n) : 0.0;
+}
+
+BoundingBox boundingBox(const Pattern &p)
+{
+    BoundingBox box;
+    const unsigned char *d = bytes(p);
+    const size_t w = static_cast<size_t>(p.width);
+    int top = 0;
+    while (top < p.height && !anyRange(d + top * w, w)) ++top;
+    if (top == p.height) return box;
+    int bottom = p.height - 1;
+    while (bottom > top && !anyRange(d + bottom * w, w)) --bottom;
+
+    // Narrow [minX, maxX] row by row; each row only needs scanning outside the current range
+    int minX = p.width, maxX = -1;
+    for (int y = top; y <= bottom; ++y) {
+        const unsigned char *row = d + y * w;
+        for (int x = 0; x < minX; ++x) {
+            if (row[x]) { minX = x; break; }
+        }
+        for (int x = p.width - 1; x > maxX; --x) {
+            if (row[x]) { maxX = x; break; }
+        }
+    }
+    box.x0 = minX;
+    box.y0 = top;
+    box.x1 = maxX + 1;
+    box.y1 = bottom + 1;
+    box.empty = false;
+    return box;
+}
+
+std::vector<int> rowHistogram(const Pattern &p)
+{
+    std::vector<int> hist(std::max(0, p.height), 0);
+    const size_t w = static_cast<size_t>(p.width);
+    for (int y = 0; y < p.height; ++y) hist[y] = static_cast<int>(countRange(bytes(p) + y * w, w));
+    return hist;
+}
+
+std::vector<int> columnHistogram(const Pattern &p)
+{
+    std::vector<int> hist(std::max(0, p.width), 0);
+    const unsigned char *d = bytes(p);
+    for (int y = 0; y < p.height; ++y) {
+        const unsigned char *row = d + static_cast<size_t>(y) * p.width;
+        for (int x = 0; x < p.width; ++x) hist[x] += row[x];
+    }
+    return hist;
+}
+
+bool patternsEqual(const Pattern &a, const Pattern &b)
+{
+    if (a.width != b.width || a.height != b.height) return false;
+    return std::memcmp(a.data, b.data, pixelCount(a)) == 0;
+}
+
+size_t diffCount(const Pattern &a, const Pattern &b)
+{
+    if (a.width == b.width && a.height == b.height) return diffRange(bytes(a), bytes(b), pixelCount(a));
+
+    size_t count = 0;
+    const int common = std::min(a.width, b.width);
+    for (int y = 0; y < std::max(a.height, b.height); ++y) {
+        const unsigned char *ra = (y < a.height) ? bytes(a) + static_cast<size_t>(y) * a.width : nullptr;
+        const unsigned char *rb = (y < b.height) ? bytes(b) + static_cast<size_t>(y) * b.width : nullptr;
+        if (ra && rb) {
+            count += diffRange(ra, rb, common);
+            count += (a.width > common) ? countRange(ra + common, a.width - common) : countRange(rb + common, b.width - common);
+        } else {
+            count += ra ? countRange(ra, a.width) : countRange(rb, b.width);
+        }
+    }
+    return count;
+}
+
+Pattern diffPattern(const Pattern &a, const Pattern &b)
+{
+    const int w = std::max(a.width, b.width);
+    const int h = std::max(a.height, b.height);
+    Pattern out(w, h);
+    unsigned char *o = reinterpret_cast<unsigned char*>(out.data);
+    for (int y = 0; y < h; ++y) {
+        unsigned char *ro = o + static_cast<size_t>(y) * w;
+        const int wa = (y < a.height) ? a.width : 0;
+        const int wb = (y < b.height) ? b.width : 0;
+        const unsigned char *ra = wa ? bytes(a) + static_cast<size_t>(y) * a.width : nullptr;
+        const unsigned char *rb = wb ? bytes(b) + static_cast<size_t>(y) * b.width : nullptr;
+        const int common = std::min(wa, wb);
+        for (int x = 0; x < common; ++x) ro[x] = ra[x] ^ rb[x];
+        if (wa > common) std::memcpy(ro + common, ra + common, wa - common);
+        if (wb > common) std::memcpy(ro + common, rb + common, wb - common);
+    }
+    return out;
+}
+
+uint64_t patternHash(const Pattern &p)
+{
+    // MurmurHash3-style word mixing seeded with the dimensions
+    const uint64_t c1 = 0x87c37b91114253d5ull, c2 = 0x4cf5ad432745937full;
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ (static_cast<uint64_t>(static_cast<uint32_t>(p.width)) << 32 | static_cast<uint32_t>(p.height));
+    const unsigned char *d = bytes(p);
+    const size_t n = pixelCount(p);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t k = load64le(d + i);
+        k *= c1; k = rotl(k, 31); k *= c2;
+        h ^= k;
+        h = rotl(h, 27) * 5 + 0x52dce729;
+    }
+    uint64_t tail = 0;
+    for (size_t j = 0; i + j < n; ++j) tail |= static_cast<uint64_t>(d[i + j]) << (8 * j);
+    tail *= c1; tail = rotl(tail, 31); tail *= c2;
+    h ^= tail;
+    return fmix64(h ^ n);
+}
@@ -0,0 +1,36 @@
+#ifndef PATTERN_STATS_H
+#define PATTERN_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "pattern.h"
+
+// Statistics and comparisons over Patterns, computed 8 pixels per 64-bit word with popcount.
+// When two Patterns differ in size, pixels outside the smaller one count as false.
+
+// Set pixels span [x0, x1) x [y0, y1); empty == true (and all zero) when nothing is set
+struct BoundingBox {
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    bool empty = true;
+};
+
+size_t countSetPixels(const Pattern &p);
+// Fraction of set pixels in [0, 1]
+double coverage(const Pattern &p);
+BoundingBox boundingBox(const Pattern &p);
+// Set pixels per row (height entries) / per column (width entries)
+std::vector<int> rowHistogram(const Pattern &p);
+std::vector<int> columnHistogram(const Pattern &p);
+
+// Same size and same pixels; stops at the first differing word
+bool patternsEqual(const Pattern &a, const Pattern &b);
+// Number of pixels that differ
+size_t diffCount(const Pattern &a, const Pattern &b);
+// Differing pixels as a mask (size: max of both widths x max of both heights)
+Pattern diffPattern(const Pattern &a, const Pattern &b);
+
+// 64-bit content hash over size and pixels; independent of platform byte order
+uint64_t patternHash(const Pattern &p);
+
+#endif // PATTERN_STATS_H
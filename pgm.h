@@ -3,20 +3,35 @@
 #define PGM_H
 #include <fstream>
 #include <cstdint>
+
+// On-disk encoding used by the save functions: raw Netpbm (P5/P6) or the compact lossless LIMG codec (limg.h)
+enum class ImageFormat
+{
+    Netpbm,
+    Limg
+};
+
 struct P5
 {
     int width;
     int height;
     unsigned char *img_data;
+    bool ownsData = true;
 
     P5(int w, int h) : width(w), height(h)
     {
         img_data = new unsigned char[width * height];
     }
 
+    // Wraps a caller-owned buffer of w * h bytes without copying
+    P5(int w, int h, unsigned char *buffer) : width(w), height(h), img_data(buffer), ownsData(false) {}
+
+    P5(const P5 &) = delete;
+    P5 &operator=(const P5 &) = delete;
+
     ~P5()
     {
-        delete[] img_data;
+        if (ownsData) delete[] img_data;
     }
 };
 
@@ -27,6 +42,7 @@ struct P6
     unsigned char *r;
     unsigned char *g;
     unsigned char *b;
+    bool ownsData = true;
 
     P6(int w, int h) : width(w), height(h)
     {
@@ -35,8 +51,16 @@ struct P6
         b = new unsigned char[width * height];
     }
 
+    // Wraps three caller-owned planes of w * h bytes without copying
+    P6(int w, int h, unsigned char *red, unsigned char *green, unsigned char *blue)
+        : width(w), height(h), r(red), g(green), b(blue), ownsData(false) {}
+
+    P6(const P6 &) = delete;
+    P6 &operator=(const P6 &) = delete;
+
     ~P6()
     {
+        if (!ownsData) return;
         delete[] r;
         delete[] g;
         delete[] b;
@@ -61,11 +85,18 @@ inline std::ostream &operator<<(std::ostream &s, const P6 &img)
     s << "255\n";
 
     const auto byteCount = static_cast<std::streamsize>(img.width) * static_cast<std::streamsize>(img.height);
-    for (std::streamsize i = 0; i < byteCount; ++i)
+    // Interleave the planes through a small buffer instead of one put() per byte
+    char chunk[3 * 4096];
+    for (std::streamsize i = 0; i < byteCount; i += 4096)
     {
-        s.put(static_cast<char>(img.r[i]));
-        s.put(static_cast<char>(img.g[i]));
-        s.put(static_cast<char>(img.b[i]));
+        const std::streamsize n = (byteCount - i < 4096) ? byteCount - i : 4096;
+        for (std::streamsize j = 0; j < n; ++j)
+        {
+            chunk[3 * j] = static_cast<char>(img.r[i + j]);
+            chunk[3 * j + 1] = static_cast<char>(img.g[i + j]);
+            chunk[3 * j + 2] = static_cast<char>(img.b[i + j]);
+        }
+        s.write(chunk, 3 * n);
     }
     return s;
 }
@@ -0,0 +1,454 @@
+// Render daemon: serves layer-stack renders over a Unix domain socket, keeping the worker pool and
+// the layer cache warm between requests. Protocol (one request per line, requests may be pipelined):
+//
+//   RENDER <width> <height> <pgm|limg> <layer> [<layer> ...] [shm=<name>]
+//       layer = [op][!]<generator>[:<arg>]   op: & AND, | OR, ^ XOR (ignored on the first layer, default |)
+//       generators: circle:<radius>  triangle  checker:<size>  maze:<seed>  load:<file in ./patterns/>
+//     -> "OK <n>\n" followed by n bytes of the encoded image, or with shm=<name> the image is written to
+//        the POSIX shared memory object /<name> and the reply is "SHM <name> <n>\n"
+//   PING  -> "PONG\n"
+//   STATS -> "STATS requests=<n> cache_bytes=<n> cache_hits=<n> cache_misses=<n>\n"
+//   QUIT  -> closes the connection
+//   Errors are reported as "ERR <message>\n"; the connection stays usable.
+//
+// All complete lines received in one read are handled as a batch: rendered in parallel, answered in order.
+// A request may cover at most maxPixels pixels. Requests being rendered or waiting to be sent (across the
+// batch and all connections) share a memory budget of maxInFlightBytes; a request waits until its estimate
+// fits and gives its share back once its reply has been sent.
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pattern.h"
+#include "layer_cache.h"
+#include "layer_stack.h"
+#include "memstream.h"
+#include "parallel.h"
+
+static std::atomic<unsigned long> requestCount(0);
+
+static const int maxDimension = 32768;
+static const size_t maxPixels = size_t(1) << 26;        // 64 Mpx per request, e.g. 8192 x 8192
+static const size_t maxInFlightBytes = size_t(1) << 30; // shared by all requests being rendered
+static const size_t maxLineLength = 1 << 16;
+static const int sendTimeoutSeconds = 30;            // a reply not accepted within this time drops the connection
+
+struct RenderRequest {
+    int width = 0;
+    int height = 0;
+    ImageFormat format = ImageFormat::Netpbm;
+    std::vector<std::string> layerSpecs;
+    std::string shmName;
+
+    // Peak bytes held while rendering: one Pattern per layer, the combined Pattern, the encoded
+    // image and the reply that carries it (at most one byte per pixel each for these formats)
+    size_t estimatedBytes() const
+    {
+        return static_cast<size_t>(width) * height * (layerSpecs.size() + 3) + 4096;
+    }
+};
+
+// Holds part of maxInFlightBytes for the lifetime of one render
+class RenderBudget {
+public:
+    explicit RenderBudget(size_t bytes) : reserved(bytes)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        freed.wait(lock, [&]() { return inFlight + reserved <= maxInFlightBytes; });
+        inFlight += reserved;
+    }
+    ~RenderBudget()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            inFlight -= reserved;
+        }
+        freed.notify_all();
+    }
+    RenderBudget(const RenderBudget&) = delete;
+    RenderBudget& operator=(const RenderBudget&) = delete;
+
+private:
+    size_t reserved;
+    static std::mutex mtx;
+    static std::condition_variable freed;
+    static size_t inFlight;
+};
+
+std::mutex RenderBudget::mtx;
+std::condition_variable RenderBudget::freed;
+size_t RenderBudget::inFlight = 0;
+
+// Loads a Pattern from ./patterns/ and checks that it matches the canvas
+static bool loadLayerPattern(const std::string &name, int width, int height, Pattern &out, std::string &err)
+{
+    std::ifstream file("./patterns/" + name, std::ios::in | std::ios::binary);
+    if (!file) {
+        err = "cannot open '" + name + "'";
+        return false;
+    }
+    out = readPatternFromPgm(file);
+    if (out.width != width || out.height != height) {
+        err = "'" + name + "' is " + std::to_string(out.width) + "x" + std::to_string(out.height) +
+              " (or unreadable), expected " + std::to_string(width) + "x" + std::to_string(height);
+        return false;
+    }
+    return true;
+}
+
+// Builds one layer from "<generator>[:<arg>]"; returns false and sets err on bad input
+static bool makeLayerPattern(const std::string &spec, int width, int height, Pattern &out, std::string &err)
+{
+    const size_t colon = spec.find(':');
+    const std::string gen = spec.substr(0, colon);
+    const std::string arg = (colon == std::string::npos) ? "" : spec.substr(colon + 1);
+    char *end = nullptr;
+    const long num = std::strtol(arg.c_str(), &end, 10);
+    const bool numeric = !arg.empty() && *end == '\0';
+
+    if (gen == "circle" && numeric) {
+        out = cachedCirclePattern(defaultLayerCache(), width, height, static_cast<int>(num));
+    } else if (gen == "triangle") {
+        out = cachedTrianglePattern(defaultLayerCache(), width, height);
+    } else if (gen == "checker" && numeric && num >= 1) {
+        out = cachedCheckerboardPattern(defaultLayerCache(), width, height, static_cast<int>(num));
+    } else if (gen == "maze" && numeric) {
+        out = cachedLabyrinthPattern(defaultLayerCache(), width, height, static_cast<unsigned>(num));
+    } else if (gen == "load" && !arg.empty() && arg.find('/') == std::string::npos && arg.find("..") == std::string::npos) {
+        return loadLayerPattern(arg, width, height, out, err);
+    } else {
+        err = "bad layer '" + spec + "'";
+        return false;
+    }
+    return true;
+}
+
+static bool parseRenderRequest(std::istringstream &in, RenderRequest &req, std::string &err)
+{
+    std::string fmt;
+    if (!(in >> req.width >> req.height >> fmt)) {
+        err = "usage: RENDER <width> <height> <pgm|limg> <layer>...";
+        return false;
+    }
+    if (req.width <= 0 || req.height <= 0 || req.width > maxDimension || req.height > maxDimension) {
+        err = "dimensions must be 1.." + std::to_string(maxDimension);
+        return false;
+    }
+    if (static_cast<size_t>(req.width) * req.height > maxPixels) {
+        err = "at most " + std::to_string(maxPixels) + " pixels per request";
+        return false;
+    }
+    if (fmt == "pgm") req.format = ImageFormat::Netpbm;
+    else if (fmt == "limg") req.format = ImageFormat::Limg;
+    else {
+        err = "unknown format '" + fmt + "'";
+        return false;
+    }
+
+    std::string tok;
+    while (in >> tok) {
+        if (tok.compare(0, 4, "shm=") == 0) {
+            req.shmName = tok.substr(4);
+            if (req.shmName.empty() || req.shmName.find('/') != std::string::npos) {
+                err = "bad shm name";
+                return false;
+            }
+            continue;
+        }
+        req.layerSpecs.push_back(tok);
+    }
+    if (req.layerSpecs.empty()) {
+        err = "no layers";
+        return false;
+    }
+    if (req.estimatedBytes() > maxInFlightBytes) {
+        err = "request needs more than " + std::to_string(maxInFlightBytes >> 20) + " MiB; use fewer layers or a smaller canvas";
+        return false;
+    }
+    return true;
+}
+
+// Generates the layers of a parsed request; returns false and sets err on a bad layer
+static bool buildLayers(const RenderRequest &req, std::vector<Layer> &layers, std::string &err)
+{
+    for (const std::string &tok : req.layerSpecs) {
+        char op = '|';
+        size_t pos = 0;
+        if (tok[pos] == '&' || tok[pos] == '|' || tok[pos] == '^') op = tok[pos++];
+        bool negated = false;
+        if (pos < tok.size() && tok[pos] == '!') {
+            negated = true;
+            ++pos;
+        }
+        Pattern p(0, 0);
+        if (!makeLayerPattern(tok.substr(pos), req.width, req.height, p, err)) return false;
+        Layer layer(tok, std::move(p));
+        layer.negated = negated;
+        layer.op = layers.empty() ? ' ' : op;
+        layers.push_back(std::move(layer));
+    }
+    return true;
+}
+
+static bool writeSharedMemory(const std::string &name, const std::vector<unsigned char> &bytes, std::string &err)
+{
+    const std::string path = "/" + name;
+    const int fd = shm_open(path.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        err = std::string("shm_open: ") + std::strerror(errno);
+        return false;
+    }
+    bool ok = ftruncate(fd, static_cast<off_t>(bytes.size())) == 0;
+    if (ok && !bytes.empty()) {
+        void *mem = mmap(nullptr, bytes.size(), PROT_WRITE, MAP_SHARED, fd, 0);
+        ok = mem != MAP_FAILED;
+        if (ok) {
+            std::memcpy(mem, bytes.data(), bytes.size());
+            munmap(mem, bytes.size());
+        }
+    }
+    if (!ok) err = std::string("shared memory: ") + std::strerror(errno);
+    close(fd);
+    return ok;
+}
+
+// Handles one request line up to rendering. Returns true with req filled in when the line is a valid
+// RENDER request; otherwise reply holds the full answer. QUIT is handled by serveConnection.
+static bool parseLine(const std::string &line, RenderRequest &req, std::string &reply)
+{
+    std::istringstream in(line);
+    std::string cmd;
+    in >> cmd;
+    if (cmd.empty()) {
+        reply.clear();
+        return false;
+    }
+    if (cmd == "PING") {
+        reply = "PONG\n";
+        return false;
+    }
+    if (cmd == "STATS") {
+        LayerCache &cache = defaultLayerCache();
+        reply = "STATS requests=" + std::to_string(requestCount.load()) + " cache_bytes=" + std::to_string(cache.bytesUsed()) +
+                " cache_hits=" + std::to_string(cache.hits()) + " cache_misses=" + std::to_string(cache.misses()) + "\n";
+        return false;
+    }
+    if (cmd != "RENDER") {
+        reply = "ERR unknown command '" + cmd + "'\n";
+        return false;
+    }
+
+    ++requestCount;
+    std::string err;
+    if (!parseRenderRequest(in, req, err)) {
+        reply = "ERR " + err + "\n";
+        return false;
+    }
+    return true;
+}
+
+// Renders a parsed request; returns the full reply (header and payload)
+static std::string renderReply(const RenderRequest &req)
+{
+    // A failed allocation (or anything else thrown while rendering) fails this request, not the daemon
+    try {
+        std::string err;
+        std::vector<unsigned char> bytes;
+        {
+            std::vector<Layer> layers;
+            if (!buildLayers(req, layers, err)) return "ERR " + err + "\n";
+            Pattern combined = combineLayersTiled(layers, req.width, req.height);
+            layers.clear();
+            bytes = encodePatternToVector(combined, req.format);
+        }
+        if (!req.shmName.empty()) {
+            if (!writeSharedMemory(req.shmName, bytes, err)) return "ERR " + err + "\n";
+            return "SHM " + req.shmName + " " + std::to_string(bytes.size()) + "\n";
+        }
+        std::string reply = "OK " + std::to_string(bytes.size()) + "\n";
+        reply.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        return reply;
+    } catch (const std::exception &e) {
+        return std::string("ERR render failed: ") + e.what() + "\n";
+    }
+}
+
+static bool sendAll(int fd, const std::string &data)
+{
+    size_t off = 0;
+    while (off < data.size()) {
+        const ssize_t n = send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        off += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Orders the requests of one batch: budget is reserved in request order, and replies are sent in request
+// order as soon as they are ready, each releasing its reservation once it is on the wire. So a request's
+// memory is held until its reply has been sent (a finished reply cannot pile up outside the budget), and
+// the earliest unsent request of a connection always holds its reservation, so the batch cannot deadlock.
+class ReplySequencer {
+public:
+    ReplySequencer(int fd, size_t count) : fd(fd), replies(count), budgets(count), ready(count, false) {}
+
+    // Waits until every earlier request has reserved, then reserves bytes (none when 0)
+    std::unique_ptr<RenderBudget> reserveInOrder(size_t index, size_t bytes)
+    {
+        std::unique_lock<std::mutex> lock(turnMutex);
+        turnChanged.wait(lock, [&]() { return nextReserve == index; });
+        std::unique_ptr<RenderBudget> budget;
+        if (bytes) budget.reset(new RenderBudget(bytes));
+        ++nextReserve;
+        turnChanged.notify_all();
+        return budget;
+    }
+
+    // Stores the reply of request index and sends every reply that is now due
+    void complete(size_t index, std::string reply, std::unique_ptr<RenderBudget> budget)
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        replies[index] = std::move(reply);
+        budgets[index] = std::move(budget);
+        ready[index] = true;
+        while (nextSend < ready.size() && ready[nextSend]) {
+            if (!failed && !sendAll(fd, replies[nextSend])) failed = true;
+            std::string().swap(replies[nextSend]);
+            budgets[nextSend].reset();
+            ++nextSend;
+        }
+    }
+
+    // True once a send failed; later replies are dropped
+    bool sendFailed()
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        return failed;
+    }
+
+private:
+    int fd;
+    std::mutex turnMutex;
+    std::condition_variable turnChanged;
+    size_t nextReserve = 0;
+    std::mutex sendMutex;
+    std::vector<std::string> replies;
+    std::vector<std::unique_ptr<RenderBudget>> budgets;
+    std::vector<bool> ready;
+    size_t nextSend = 0;
+    bool failed = false;
+};
+
+static void serveConnection(int fd)
+{
+    // A client that stops reading would otherwise pin its replies' share of the render budget forever
+    timeval timeout;
+    timeout.tv_sec = sendTimeoutSeconds;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string pending;
+    char chunk[1 << 16];
+    bool quit = false;
+    while (!quit) {
+        const ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(chunk, static_cast<size_t>(n));
+
+        std::vector<std::string> lines;
+        size_t start = 0, nl;
+        while ((nl = pending.find('\n', start)) != std::string::npos) {
+            std::string line = pending.substr(start, nl - start);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            lines.push_back(line);
+            start = nl + 1;
+        }
+        pending.erase(0, start);
+        if (pending.size() > maxLineLength) {
+            sendAll(fd, "ERR request line too long\n");
+            break;
+        }
+
+        // Stop the batch at QUIT so nothing after it is executed
+        size_t count = lines.size();
+        for (size_t i = 0; i < lines.size(); ++i) {
+            std::istringstream cmd(lines[i]);
+            std::string token;
+            cmd >> token;
+            if (token == "QUIT") {
+                count = i;
+                quit = true;
+                break;
+            }
+        }
+        // parallelFor hands out indices in increasing order, which reserveInOrder relies on
+        ReplySequencer sequencer(fd, count);
+        parallelFor(static_cast<int>(count), [&](int i) {
+            RenderRequest req;
+            std::string reply;
+            const bool render = parseLine(lines[i], req, reply);
+            std::unique_ptr<RenderBudget> budget = sequencer.reserveInOrder(i, render ? req.estimatedBytes() : 0);
+            if (render) reply = renderReply(req);
+            sequencer.complete(i, std::move(reply), std::move(budget));
+        });
+        if (sequencer.sendFailed()) quit = true;
+    }
+    close(fd);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = (argc > 1) ? argv[1] : "/tmp/learnimg.sock";
+    signal(SIGPIPE, SIG_IGN);
+
+    const int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0) {
+        std::cerr << "socket: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (std::strlen(path) >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << "\n";
+        return 1;
+    }
+    std::strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(server, 64) < 0) {
+        std::cerr << "Failed to listen on " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::cerr << "renderd listening on " << path << "\n";
+
+    for (;;) {
+        const int client = accept(server, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "accept: " << std::strerror(errno) << "\n";
+            break;
+        }
+        std::thread(serveConnection, client).detach();
+    }
+    close(server);
+    unlink(path);
+    return 0;
+}
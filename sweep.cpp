@@ -0,0 +1,231 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "sweep.h"
+#include "limg.h"
+#include "parallel.h"
+
+namespace {
+
+// A snapshot of one frame; exactly one of the two members is set
+struct Frame {
+    std::unique_ptr<Pattern> mask;
+    std::unique_ptr<P5> gray;
+};
+
+void encodeFrame(std::ostream &s, const Frame &f, ImageFormat format)
+{
+    if (f.mask) writePatternAsPgm(s, *f.mask, format);
+    else if (format == ImageFormat::Limg) encodeLimg(s, *f.gray);
+    else s << *f.gray;
+}
+
+// Collects frame snapshots and encodes/writes them in parallel batches, preserving frame order
+class FrameSink {
+public:
+    explicit FrameSink(const SweepOutput &o) : out(o)
+    {
+        threads = out.threads > 0 ? out.threads : defaultThreadCount();
+        batchSize = threads * 2;
+        ext = (out.format == ImageFormat::Limg) ? ".limg" : ".pgm";
+        if (out.singleStream) {
+            const std::string path = std::string("./patterns/") + out.prefix + ext;
+            stream.open(path.c_str(), std::ios::out | std::ios::binary);
+            if (!stream) std::cerr << "Failed to open " << path << " for writing\n";
+        }
+    }
+
+    ~FrameSink() { flush(); }
+
+    void push(const Pattern &p)
+    {
+        Frame f;
+        f.mask.reset(new Pattern(p));
+        pending.push_back(std::move(f));
+        if ((int)pending.size() >= batchSize) flush();
+    }
+
+    void push(const P5 &img)
+    {
+        Frame f;
+        f.gray.reset(new P5(img.width, img.height));
+        std::memcpy(f.gray->img_data, img.img_data, static_cast<size_t>(img.width) * img.height);
+        pending.push_back(std::move(f));
+        if ((int)pending.size() >= batchSize) flush();
+    }
+
+private:
+    void flush()
+    {
+        if (pending.empty()) return;
+        if (out.singleStream) {
+            std::vector<std::string> encoded(pending.size());
+            parallelFor((int)pending.size(), [&](int i) {
+                std::ostringstream s(std::ios::out | std::ios::binary);
+                encodeFrame(s, pending[i], out.format);
+                encoded[i] = s.str();
+            }, threads);
+            for (const auto &e : encoded) stream.write(e.data(), static_cast<std::streamsize>(e.size()));
+            if (!stream) std::cerr << "Failed while writing " << out.prefix << ext << "\n";
+        } else {
+            parallelFor((int)pending.size(), [&](int i) {
+                char num[16];
+                std::snprintf(num, sizeof(num), "_%05d", frameIndex + i);
+                const std::string path = std::string("./patterns/") + out.prefix + num + ext;
+                std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+                if (!file) {
+                    std::cerr << "Failed to open " << path << " for writing\n";
+                    return;
+                }
+                encodeFrame(file, pending[i], out.format);
+                if (!file) std::cerr << "Failed while writing " << path << "\n";
+            }, threads);
+        }
+        frameIndex += (int)pending.size();
+        pending.clear();
+    }
+
+    const SweepOutput &out;
+    int threads;
+    int batchSize;
+    int frameIndex = 0;
+    const char *ext;
+    std::ofstream stream;
+    std::vector<Frame> pending;
+};
+
+// Largest k >= 0 with k*k <= v, or -1 when v < 0
+int isqrtFloor(long long v)
+{
+    if (v < 0) return -1;
+    long long k = static_cast<long long>(std::sqrt(static_cast<double>(v)));
+    while (k * k > v) --k;
+    while ((k + 1) * (k + 1) <= v) ++k;
+    return static_cast<int>(k);
+}
+
+// Moves row y of a circle mask from half-width oldHw to newHw (-1 = row empty), touching only the difference
+void updateCircleRow(Pattern &p, int y, int cx, int oldHw, int newHw)
+{
+    bool *row = p.data + static_cast<size_t>(y) * p.width;
+    const bool grow = newHw > oldHw;
+    const int inner = grow ? oldHw : newHw; // pixels with |dx| <= inner stay as they are
+    const int outer = grow ? newHw : oldHw;
+    // Left part: dx in [-outer, -inner - 1], right part: dx in [inner + 1, outer]
+    const int l0 = std::max(0, cx - outer), l1 = std::min(p.width, cx - inner);
+    const int r0 = std::max(0, cx + inner + 1), r1 = std::min(p.width, cx + outer + 1);
+    if (inner < 0) {
+        // Row appears or disappears entirely: one contiguous span
+        const int s0 = std::max(0, cx - outer), s1 = std::min(p.width, cx + outer + 1);
+        if (s1 > s0) std::memset(row + s0, grow, s1 - s0);
+        return;
+    }
+    if (l1 > l0) std::memset(row + l0, grow, l1 - l0);
+    if (r1 > r0) std::memset(row + r0, grow, r1 - r0);
+}
+
+} // namespace
+
+void renderCircleSweep(int width, int height, int rFrom, int rTo, const SweepOutput &out)
+{
+    FrameSink sink(out);
+    Pattern frame(width, height);
+    const int cx = width / 2;
+    const int cy = height / 2;
+    std::vector<int> halfWidth(height, -1); // current span half-width per row, -1 = empty
+    const int step = (rTo >= rFrom) ? 1 : -1;
+    int prevReach = -1; // rows |dy| <= prevReach may be non-empty
+
+    for (int r = rFrom; ; r += step) {
+        const long long r2 = static_cast<long long>(r) * r;
+        const int reach = std::abs(r);
+        const int span = std::max(reach, prevReach);
+        for (int y = std::max(0, cy - span); y <= std::min(height - 1, cy + span); ++y) {
+            const long long dy = y - cy;
+            const int hw = isqrtFloor(r2 - dy * dy);
+            if (hw != halfWidth[y]) {
+                updateCircleRow(frame, y, cx, halfWidth[y], hw);
+                halfWidth[y] = hw;
+            }
+        }
+        prevReach = reach;
+        sink.push(frame);
+        if (r == rTo) break;
+    }
+}
+
+void renderCheckerboardSweep(int width, int height, int sFrom, int sTo, const SweepOutput &out)
+{
+    if (sFrom < 1 || sTo < 1) {
+        std::cerr << "Checkerboard square size must be >= 1\n";
+        return;
+    }
+    FrameSink sink(out);
+    Pattern frame(width, height);
+    std::unique_ptr<bool[]> rows(new bool[2 * static_cast<size_t>(width)]);
+    const int step = (sTo >= sFrom) ? 1 : -1;
+
+    for (int s = sFrom; ; s += step) {
+        // Only two distinct rows exist: bands with even and odd y / s
+        for (int x = 0; x < width; ++x) {
+            rows[x] = (x / s) % 2 == 0;
+            rows[width + x] = !rows[x];
+        }
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(frame.data + static_cast<size_t>(y) * width, rows.get() + ((y / s) % 2) * width, width);
+        }
+        sink.push(frame);
+        if (s == sTo) break;
+    }
+}
+
+void renderBallLightSweep(int width, int height, int frames, double lxFrom, double lyFrom,
+                          double lxTo, double lyTo, const SweepOutput &out)
+{
+    FrameSink sink(out);
+    P5 img(width, height);
+    std::memset(img.img_data, 0, static_cast<size_t>(width) * height);
+    const int cx = width / 2;
+    const int cy = height / 2;
+    const int radius = std::min(width, height) / 2 - 4;
+    const double r2 = static_cast<double>(radius) * radius;
+    const int y0 = std::max(0, cy - radius), y1 = std::min(height - 1, cy + radius);
+
+    for (int f = 0; f < frames; ++f) {
+        const double t = (frames > 1) ? static_cast<double>(f) / (frames - 1) : 0.0;
+        double lx = lxFrom + t * (lxTo - lxFrom), ly = lyFrom + t * (lyTo - lyFrom), lz = 1.0;
+        const double len = std::sqrt(lx*lx + ly*ly + lz*lz);
+        lx /= len; ly /= len; lz /= len;
+
+        // The silhouette never changes: the background stays 0 and only ball pixels are reshaded
+        parallelFor(y1 - y0 + 1, [&](int row) {
+            const int y = y0 + row;
+            const int dy = y - cy;
+            const double ny = dy / static_cast<double>(radius);
+            const double rowLight = ny * ly;
+            const int hw = isqrtFloor(static_cast<long long>(radius) * radius - static_cast<long long>(dy) * dy);
+            unsigned char *dst = img.img_data + static_cast<size_t>(y) * width;
+            for (int x = std::max(0, cx - hw); x <= std::min(width - 1, cx + hw); ++x) {
+                const int dx = x - cx;
+                const double dist2 = dx*dx + dy*dy;
+                const double nx = dx / static_cast<double>(radius);
+                const double nz = std::sqrt(r2 - dist2) / radius;
+                const double dot = nx*lx + rowLight + nz*lz;
+                const double intensity = std::max(0.0, dot);
+                const double rz = std::max(0.0, 2*dot*nz - lz);
+                // rz^20 by squaring instead of std::pow
+                const double rz2 = rz*rz, rz4 = rz2*rz2, rz5 = rz4*rz, rz10 = rz5*rz5;
+                const int val = (int)(40 + 180 * intensity + 35 * rz10*rz10);
+                dst[x] = static_cast<unsigned char>(std::min(255, std::max(0, val)));
+            }
+        }, out.threads);
+        sink.push(img);
+    }
+}
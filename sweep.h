@@ -0,0 +1,30 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "pgm.h"
+#include "pattern.h"
+
+// Where and how sweep frames are written
+struct SweepOutput {
+    const char *prefix;                          // frame i -> ./patterns/<prefix>_00000.<ext>, ...
+    bool singleStream = false;                   // true: all frames concatenated into ./patterns/<prefix>.<ext>
+    ImageFormat format = ImageFormat::Netpbm;    // ext is pgm for Netpbm, limg for LIMG
+    int threads = 0;                             // encoder threads (<= 0: all cores)
+    explicit SweepOutput(const char *p) : prefix(p) {}
+};
+
+// Every frame equals the corresponding generator output. Only the circle sweep is incremental: each
+// frame starts from the previous one and rewrites just the rows whose span changed (the added or
+// removed ring). The other sweeps rebuild every frame, just cheaper than calling the generator:
+// checkerboards build the two distinct rows once and copy them into all rows, and the ball keeps its
+// silhouette but reshades every ball pixel. Frames are encoded and written in parallel batches.
+
+// One frame per radius from rFrom to rTo inclusive (either direction), like generateCirclePattern
+void renderCircleSweep(int width, int height, int rFrom, int rTo, const SweepOutput &out);
+// One frame per square size from sFrom to sTo inclusive (sizes must be >= 1), like generateCheckerboardPattern
+void renderCheckerboardSweep(int width, int height, int sFrom, int sTo, const SweepOutput &out);
+// `frames` frames of the generate3DBallPgm ball, light (x, y) moving linearly from (lxFrom, lyFrom) to (lxTo, lyTo), z = 1
+void renderBallLightSweep(int width, int height, int frames, double lxFrom, double lyFrom,
+                          double lxTo, double lyTo, const SweepOutput &out);
+
+#endif // SWEEP_H